@@ -5,23 +5,22 @@
 #include <string>
 #include "TIA.h"
 
-TIA::TIA(std::string colormap_file, int horizontal_res, int vertical_res) {//constructor, create vbuffer
+TIA::TIA(std::string colormap_file, int horizontal_res, int vertical_res) : frame(horizontal_res, vertical_res) {//constructor, frame holds the display buffer
 	// loading in colormap
 	TIA::load_colormap(colormap_file);
-	//initializing vbuffer
-	vbuffer = new unsigned char* [vertical_res]; //as with matrices, vertical size goes first -> 1D vector of rows 
-	for (int i = 0; i < horizontal_res; i++) { vbuffer[i] = new unsigned char[horizontal_res]; }// filling rows with collums -> 2D ARRAY
+	this->horizontal_res = horizontal_res;
+	this->vertical_res = vertical_res;
 	//reseting display counters
 	v_counter = 0;
 	h_counter = 0;
 }
 
-/* void TIA::tia_tick(Processor cpu) { //TIA clock cycle
+/* void TIA::tia_tick(Processor& cpu) { //TIA clock cycle
 	
 	//get color of pixel to display, part of TIA main loop
 	//unsigned char pixel = color_of_pixel(h_counter); // remember, A2600 only sees scanlines
 	//int pixel_RGB = get_RGB(pixel); //convert A2600 NTSC color format to RGB for display
-	//vbuffer[v_counter][h_counter] = pixel_RGB; //write to display buffer
+	//frame.row(v_counter)[h_counter] = pixel; //write to display buffer
 
 	//what to do if at end of display
 	h_counter = h_counter + 1; //going to next pixel on scanline
@@ -3,8 +3,10 @@
 #ifndef TIA_H
 #define TIA_H
 
-class TIA {
 #include "cpu.h"
+#include "framebuffer.h"
+
+class TIA {
 public:
 	//TIA registers Write only
 	unsigned char VSYNC; //$00, bit 1. Vertical sync set-clear
@@ -65,10 +67,10 @@ public:
 	unsigned char INPT5; //$3D, bit 7, read input
 	
 	//video buffer attributes
-	unsigned char** vbuffer; //buffer to display
+	FrameBuffer frame; //double-buffered display, one indexed byte per color clock
 	int horizontal_res; //resolution including blanking sections 
 	int vertical_res; // resolution including screen and vsync lines
-	//runtime attributes of tia/vbuffer
+	//runtime attributes of tia/frame
 	bool vsync; //currently in vsync?
 	int h_counter; //internal TIA horizontal counter
 	int v_counter; //virtual TIA vertical line counter, used to address buffer. DO NOT use as TIA oepration, as it has no such counter in hardware
@@ -80,7 +82,7 @@ public:
 	unsigned char check_read(unsigned short address); //check to see if read request is part of reserved TIA addresses, may need to return data if so
 	void check_write(unsigned short address); //check to see if write request is part of reserved TIA addresses
 	void color_of_pixel(unsigned short hori_count); // uses internal registers to determine the color of the pixel that needs to be displayed for the display engine
-	void tia_tick(Processor cpu); //cycle the TIA
+	void tia_tick(Processor& cpu); //cycle the TIA
 	
 	bool addr_reserved;
 
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <cstring>
+#include <new>
+
+#include "batch.h"
+#include "cartridge.h"
+#include "snapshot.h"
+#include "framebuffer.h"
+
+BatchEmulator::BatchEmulator(int count, int horizontal_res, int vertical_res, std::string colormap_file) {
+	if (count < 1) { //the arrays and frame layout come from the first instance
+		std::cerr << "BatchEmulator: " << count << " instances requested, using 1" << std::endl;
+		count = 1;
+	}
+	this->count = count;
+	instances = new Instance*[count];
+	for (int i = 0; i < count; i++) { //sizeof(Instance) is a multiple of 64, no line is shared with anything else
+		instances[i] = new (aligned_block(sizeof(Instance))) Instance(horizontal_res, vertical_res, colormap_file);
+	}
+	frame_width = horizontal_res;
+	frame_height = vertical_res;
+	frame_stride = machine(0).frame.stride;
+	frame_bytes = (size_t)frame_stride * frame_height; //stride and FRAME_ALIGNMENT are both multiples of 64, every frame stays aligned
+	frames = aligned_block(frame_bytes * count);
+	ram = aligned_block((size_t)128 * count);
+	port_a = aligned_block(count);
+	port_b = aligned_block(count);
+	fire = aligned_block(count);
+	frame_done = aligned_block(count);
+	memset(port_a, 0xFF, count);
+	memset(port_b, 0x0B, count);
+	power_on = NULL;
+	power_on_size = 0;
+	rom = NULL;
+}
+
+BatchEmulator::~BatchEmulator() {
+	for (int i = 0; i < count; i++) {
+		instances[i]->~Instance();
+		free_block((unsigned char*)instances[i]);
+	}
+	delete[] instances;
+	free_block(frames);
+	free_block(ram);
+	free_block(port_a);
+	free_block(port_b);
+	free_block(fire);
+	free_block(frame_done);
+	delete[] power_on;
+	delete rom; //after the cartridges borrowing it
+}
+
+int BatchEmulator::load(std::string filename, std::string scheme) {
+	RomImage* image = RomImage::map_file(filename);
+	if (image == NULL) { return -1; } //file opening error
+	return insert(image, scheme);
+}
+
+int BatchEmulator::load(const unsigned char* data, int size, std::string scheme) {
+	if ((data == NULL) || (size <= 0)) { return -1; } //nothing to load, as for an empty file
+	return insert(RomImage::copy_of(data, size), scheme);
+}
+
+int BatchEmulator::insert(RomImage* image, std::string scheme) {
+	rom_info = identify_rom(image->data, image->size); //once for the whole batch
+	if (scheme == "") { scheme = rom_info.scheme; }
+	for (int i = 0; i < count; i++) {
+		Cartridge* cart = Cartridge::create(RomImage::borrow(*image), scheme);
+		if (cart == NULL) { //size does not fit the scheme. Same image and scheme every time, so only the first can fail
+			delete image;
+			return -2;
+		}
+		machine(i).insert_cartridge(cart); //drops the previous cartridge, and with it any borrow of the previous image
+		cpu(i).reset(machine(i)); //reset vector of the new cartridge
+	}
+	delete rom;
+	rom = image;
+	delete[] power_on;
+	power_on_size = snapshot_size(machine(0));
+	power_on = new unsigned char[power_on_size];
+	save_snapshot(cpu(0), machine(0), power_on, power_on_size);
+	reset_all(); //same bytes everywhere, observations included
+	return 0;
+}
+
+void BatchEmulator::reset(int index) {
+	load_snapshot(cpu(index), machine(index), power_on, power_on_size);
+	machine(index).frame.clear(); //the snapshot leaves the picture alone, the first frame would show the old one where it does not draw
+	memset(frames + index * frame_bytes, 0, frame_bytes);
+	memcpy(ram + index * 128, machine(index).riot.ram, 128);
+	frame_done[index] = 0;
+}
+
+void BatchEmulator::reset_all() {
+	for (int i = 0; i < count; i++) { reset(i); }
+}
+
+void BatchEmulator::step() {
+	step_range(0, count);
+}
+
+static void step_task(void* batch, int begin, int end) {
+	((BatchEmulator*)batch)->step_range(begin, end);
+}
+
+void BatchEmulator::step(ThreadPool& pool) {
+	int grain = count / (pool.threads() * 4); //a few chunks per thread, stealing still evens out uneven frame costs
+	pool.parallel_for(count, grain, step_task, this);
+}
+
+void BatchEmulator::step_range(int begin, int end) {
+	for (int i = begin; i < end; i++) {
+		MemIO& mem = machine(i);
+		mem.riot.port_a_input = port_a[i];
+		mem.riot.port_b_input = port_b[i];
+		mem.INPT4 = (fire[i] & 0x01) ? 0x00 : 0x80; //fire buttons pull the input low
+		mem.INPT5 = (fire[i] & 0x02) ? 0x00 : 0x80;
+		frame_done[i] = cpu(i).run_until_frame(mem);
+		memcpy(frames + i * frame_bytes, mem.frame.front(), frame_bytes);
+		memcpy(ram + i * 128, mem.riot.ram, 128);
+	}
+}
+
+int BatchEmulator::save_state(int index, unsigned char* buffer, int capacity) {
+	return save_snapshot(cpu(index), machine(index), buffer, capacity);
+}
+
+bool BatchEmulator::load_state(int index, const unsigned char* buffer, int size) {
+	if (!load_snapshot(cpu(index), machine(index), buffer, size)) { return 0; }
+	memcpy(ram + index * 128, machine(index).riot.ram, 128);
+	return 1;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#define BATCH_H
+
+#include <string>
+
+#include "cpu.h"
+#include "memory.h"
+#include "threadpool.h"
+#include "romdb.h"
+#include "romimage.h"
+
+// Many independent copies of one game, stepped a frame at a time with a single call. Actions and observations live
+// in contiguous per-field arrays (one slot per instance, FRAME_ALIGNMENT aligned) so a trainer can hand them to its
+// framework as they are: inputs are written into the action arrays before step(), frames and RAM are read from the
+// observation arrays after it. The ROM file is mapped and identified once, every instance's cartridge borrows it.
+// Each instance (its MemIO and Processor) lives in its own cache-line-aligned block, so threads stepping neighbouring
+// instances never share a line of machine state.
+
+class BatchEmulator {
+public:
+	BatchEmulator(int count, int horizontal_res = 228, int vertical_res = 262, std::string colormap_file = "colors.csv");
+	~BatchEmulator();
+	BatchEmulator(const BatchEmulator&) = delete;
+	BatchEmulator& operator=(const BatchEmulator&) = delete;
+
+	int load(std::string filename, std::string scheme = ""); //cartridge into every instance and reset them all, Loader::load_cartridge error codes
+	int load(const unsigned char* data, int size, std::string scheme = ""); //same from bytes in memory, copied once
+	RomInfo rom_info; //what load found out about the image
+	void step(); //one frame on every instance
+	void step(ThreadPool& pool); //same, instances spread over the pool's threads
+	void step_range(int begin, int end); //one frame on instances [begin, end), for callers splitting the batch between threads
+	void reset(int index); //back to the power-on state recorded by load
+	void reset_all();
+	int save_state(int index, unsigned char* buffer, int capacity); //see save_snapshot
+	bool load_state(int index, const unsigned char* buffer, int size);
+
+	int count; //instances
+	MemIO& machine(int index) { return instances[index]->mem; }
+	Processor& cpu(int index) { return instances[index]->cpu; }
+
+	//actions, read by step() before running each instance
+	unsigned char* port_a; //[count] RIOT port A lines (joystick directions, active low), 0xFF released
+	unsigned char* port_b; //[count] RIOT port B lines (console switches), 0x0B: nothing pressed
+	unsigned char* fire; //[count] bit 0 left fire button, bit 1 right, 1 = pressed
+
+	//observations, written by step()
+	int frame_width; //color clocks per line, blanking included
+	int frame_height;
+	int frame_stride; //bytes from one line to the next
+	size_t frame_bytes; //bytes from one instance's frame to the next
+	unsigned char* frames; //[count * frame_bytes] last completed frame of each instance, indexed colors
+	unsigned char* ram; //[count * 128] RIOT RAM ($80-$FF) of each instance
+	unsigned char* frame_done; //[count] 1 if the instance started a new frame within MemIO::MAX_FRAME_CYCLES
+
+	const unsigned char* frame(int index) const { return frames + index * frame_bytes; }
+	const unsigned char* ram_of(int index) const { return ram + index * 128; }
+
+private:
+	struct alignas(64) Instance {
+		MemIO mem;
+		Processor cpu;
+		Instance(int horizontal_res, int vertical_res, std::string colormap_file) : mem(0x10000, colormap_file, horizontal_res, vertical_res), cpu(mem) {}
+	};
+	Instance** instances; //each in an aligned_block of its own
+	RomImage* rom; //image every cartridge borrows, NULL before load
+	unsigned char* power_on; //snapshot taken by load, shared by every instance
+	int power_on_size;
+	int insert(RomImage* image, std::string scheme); //takes image, deletes it on failure
+};
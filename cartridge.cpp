@@ -0,0 +1,540 @@
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+
+#include "cartridge.h"
+
+// ####### base #####
+
+Cartridge::Cartridge(RomImage* image, int size, std::string scheme) {
+	this->image = image;
+	rom = image->data;
+	rom_size = size;
+	this->scheme = scheme;
+	bus = NULL;
+	watches_tia = 0;
+	for (int i = 0; i < CART_PAGES; i++) {
+		view[i] = rom;
+		hooked[i] = 0;
+	}
+}
+
+Cartridge::~Cartridge() {
+	delete image;
+}
+
+void Cartridge::attach(MemIO& mem) {
+	bus = &mem;
+	reset();
+}
+
+unsigned char Cartridge::read(unsigned short address) {
+	hotspot(address);
+	return view[cart_page(address)][address & MemIO::PAGE_MASK]; //after the switch, the byte comes from the new bank
+}
+
+void Cartridge::write(unsigned short address, unsigned char value) {
+	hotspot(address); //writes to ROM are dropped but still trigger hotspots
+}
+
+void Cartridge::tia_write(unsigned short address, unsigned char value) {
+}
+
+void Cartridge::hotspot(unsigned short address) {
+}
+
+int Cartridge::state_size() const {
+	return 0;
+}
+
+void Cartridge::save_state(unsigned char* out) const {
+}
+
+bool Cartridge::load_state(const unsigned char* in) {
+	return 1;
+}
+
+void Cartridge::map_rom(unsigned short address, int size, int offset) {
+	for (int done = 0; done < size; done += MemIO::PAGE_SIZE) {
+		int page = cart_page(address + done);
+		view[page] = rom + offset + done;
+		if (!hooked[page]) {
+			bus->read_page[page + CART_PAGES] = view[page];
+			bus->write_page[page + CART_PAGES] = NULL;
+			bus->page_device[page + CART_PAGES] = MemIO::DEV_ROM;
+		}
+	}
+	bus->remap(cart_page(address) + CART_PAGES, size / MemIO::PAGE_SIZE); //code seen through these pages changed
+}
+
+void Cartridge::map_ram(unsigned short read_address, unsigned short write_address, int size, unsigned char* ram) {
+	for (int done = 0; done < size; done += MemIO::PAGE_SIZE) {
+		int read_page = cart_page(read_address + done);
+		int write_page = cart_page(write_address + done);
+		view[read_page] = ram + done;
+		view[write_page] = ram + done; //reading the write port is undefined on the hardware, show the RAM
+		bus->read_page[read_page + CART_PAGES] = ram + done;
+		bus->read_page[write_page + CART_PAGES] = ram + done;
+		bus->write_page[write_page + CART_PAGES] = ram + done;
+		bus->page_device[read_page + CART_PAGES] = MemIO::DEV_MEMORY;
+		bus->page_device[write_page + CART_PAGES] = MemIO::DEV_MEMORY;
+	}
+	bus->remap(cart_page(read_address) + CART_PAGES, size / MemIO::PAGE_SIZE);
+	bus->remap(cart_page(write_address) + CART_PAGES, size / MemIO::PAGE_SIZE);
+}
+
+void Cartridge::hook(unsigned short address, int size) {
+	for (int done = 0; done < size; done += MemIO::PAGE_SIZE) {
+		int page = ((address + done) & MemIO::ADDRESS_MASK) >> MemIO::PAGE_BITS;
+		bus->read_page[page] = NULL;
+		bus->write_page[page] = NULL;
+		bus->page_device[page] = MemIO::DEV_CART;
+		if (page >= CART_PAGES) { hooked[page - CART_PAGES] = 1; }
+	}
+	bus->remap((address & MemIO::ADDRESS_MASK) >> MemIO::PAGE_BITS, size / MemIO::PAGE_SIZE);
+}
+
+void Cartridge::unhook(unsigned short address, int size) { //cartridge pages only, back to plain ROM
+	for (int done = 0; done < size; done += MemIO::PAGE_SIZE) {
+		int page = cart_page(address + done);
+		hooked[page] = 0;
+		bus->read_page[page + CART_PAGES] = view[page];
+		bus->write_page[page + CART_PAGES] = NULL;
+		bus->page_device[page + CART_PAGES] = MemIO::DEV_ROM;
+	}
+	bus->remap(cart_page(address) + CART_PAGES, size / MemIO::PAGE_SIZE);
+}
+
+// ####### 2K, 4K: no bank switching #####
+
+class CartStandard : public Cartridge {
+public:
+	CartStandard(RomImage* image, int size, std::string scheme) : Cartridge(image, size, scheme) {}
+	void reset() {
+		map_rom(0x1000, 0x800, 0);
+		map_rom(0x1800, 0x800, rom_size - 0x800); //2K images are mirrored in both halves
+	}
+};
+
+// ####### F8, F6, F4: 4K banks selected by hotspots below the vectors, optional Superchip RAM (SC) #####
+
+class CartF8 : public Cartridge {
+public:
+	CartF8(RomImage* image, int size, std::string scheme, unsigned short first_hotspot, int start_bank, bool superchip) : Cartridge(image, size, scheme) {
+		this->first_hotspot = first_hotspot;
+		this->start_bank = start_bank;
+		this->superchip = superchip;
+		banks = size / 0x1000;
+		memset(ram, 0, sizeof(ram));
+	}
+	void reset() {
+		hook(0x1FC0, MemIO::PAGE_SIZE); //hotspots and vectors share the last page
+		select(start_bank);
+	}
+	void hotspot(unsigned short address) {
+		int slot = (address & 0x0FFF) - (first_hotspot & 0x0FFF);
+		if ((slot >= 0) && (slot < banks)) { select(slot); }
+	}
+	void select(int bank) {
+		map_rom(0x1000, 0x1000, bank * 0x1000);
+		if (superchip) { map_ram(0x1080, 0x1000, 0x80, ram); } //write at $1000-$107F, read at $1080-$10FF
+		current_bank = bank;
+	}
+	int state_size() const { return 1 + (superchip ? sizeof(ram) : 0); }
+	void save_state(unsigned char* out) const {
+		out[0] = current_bank;
+		if (superchip) { memcpy(out + 1, ram, sizeof(ram)); }
+	}
+	bool load_state(const unsigned char* in) {
+		if (in[0] >= banks) { return 0; }
+		select(in[0]);
+		if (superchip) { memcpy(ram, in + 1, sizeof(ram)); }
+		return 1;
+	}
+
+protected:
+	unsigned short first_hotspot; //hotspot selecting bank 0, the next ones select the following banks
+	int start_bank;
+	bool superchip;
+	int banks;
+	int current_bank;
+	unsigned char ram[128];
+};
+
+// ####### FE (Activision): the bank follows bit 5 of the byte on the bus right after a stack access at $01FE #####
+
+class CartFE : public Cartridge {
+public:
+	CartFE(RomImage* image, int size, std::string scheme) : Cartridge(image, size, scheme) {
+		pending = 0;
+		pending_cycle = ~0ULL;
+	}
+	void reset() {
+		pending = 0;
+		pending_cycle = ~0ULL;
+		hook(0x01C0, MemIO::PAGE_SIZE); //stack page as seen by JSR/RTS, forwarded to RIOT RAM
+		bank = -1;
+		select(0);
+	}
+	unsigned char read(unsigned short address) {
+		unsigned char value;
+		if (address < 0x1000) { value = bus->riot.ram[address & 0x7F]; }
+		else { value = view[cart_page(address)][address & MemIO::PAGE_MASK]; }
+		access(address, value);
+		return value;
+	}
+	void write(unsigned short address, unsigned char value) {
+		if (address < 0x1000) { bus->riot.ram[address & 0x7F] = value; }
+		access(address, value);
+	}
+
+	int state_size() const { return 2; }
+	void save_state(unsigned char* out) const {
+		out[0] = bank;
+		out[1] = pending;
+	}
+	bool load_state(const unsigned char* in) {
+		if ((in[0] > 1) || (in[1] > 1)) { return 0; }
+		bank = -1;
+		select(in[0]);
+		pending = in[1];
+		pending_cycle = ~0ULL;
+		if (pending) { hook(0x1000, 0x1000); }
+		else { unhook(0x1000, 0x1000); }
+		return 1;
+	}
+
+private:
+	bool pending; //$01FE was accessed, the next access picks the bank
+	unsigned long long pending_cycle; //clock of the instruction that accessed $01FE
+	unsigned int pending_epoch;
+	unsigned int stamps[CART_PAGES]; //page generations of cartridge space before it was hooked
+	int bank;
+	void select(int bank) {
+		if (bank == this->bank) { return; } //most calls stay in their bank, the caches keep their code
+		map_rom(0x1000, 0x1000, bank * 0x1000);
+		this->bank = bank;
+	}
+	void access(unsigned short address, unsigned char value) {
+		if (pending) { //RTS: high byte pulled from $01FF, JSR: high byte of the target fetched from ROM
+			pending = 0;
+			unhook(0x1000, 0x1000);
+			if ((bus->cycles == pending_cycle) && (bus->cache_epoch == pending_epoch)) { //same JSR or RTS, no instruction was decoded while hooked
+				memcpy(bus->page_generation + CART_PAGES, stamps, sizeof(stamps)); //pages are back as they were, so are the caches
+			}
+			select((value & 0x20) ? 0 : 1); //$Fxxx is bank 0, $Dxxx bank 1
+		}
+		if (address == 0x01FE) {
+			pending = 1;
+			pending_cycle = bus->cycles;
+			pending_epoch = bus->cache_epoch;
+			memcpy(stamps, bus->page_generation + CART_PAGES, sizeof(stamps));
+			hook(0x1000, 0x1000); //next access may be a ROM fetch, catch it
+		}
+	}
+};
+
+// ####### E0 (Parker Bros): three switchable 1K slices and a fixed last one #####
+
+class CartE0 : public Cartridge {
+public:
+	CartE0(RomImage* image, int size, std::string scheme) : Cartridge(image, size, scheme) {}
+	void reset() {
+		hook(0x1FC0, MemIO::PAGE_SIZE);
+		select(0, 4);
+		select(1, 5);
+		select(2, 6);
+		map_rom(0x1C00, 0x400, 7 * 0x400); //always the last slice
+	}
+	void hotspot(unsigned short address) {
+		address = address & 0x0FFF;
+		if ((address >= 0x0FE0) && (address <= 0x0FF7)) { select((address - 0x0FE0) >> 3, address & 0x07); } //$1FE0-$1FE7 segment 0, $1FE8-$1FEF segment 1, $1FF0-$1FF7 segment 2
+	}
+	int state_size() const { return 3; }
+	void save_state(unsigned char* out) const { memcpy(out, slices, 3); }
+	bool load_state(const unsigned char* in) {
+		if ((in[0] > 7) || (in[1] > 7) || (in[2] > 7)) { return 0; }
+		for (int segment = 0; segment < 3; segment++) { select(segment, in[segment]); }
+		return 1;
+	}
+
+private:
+	unsigned char slices[3]; //1K slice shown in each switchable segment
+	void select(int segment, int slice) {
+		map_rom(0x1000 + segment * 0x400, 0x400, slice * 0x400);
+		slices[segment] = slice;
+	}
+};
+
+// ####### 3F (Tigervision): 2K lower bank picked by writes to $3F, upper 2K fixed to the last bank #####
+
+class Cart3F : public Cartridge {
+public:
+	Cart3F(RomImage* image, int size, std::string scheme) : Cartridge(image, size, scheme) {
+		watches_tia = 1;
+		banks = size / 0x800;
+	}
+	void reset() {
+		select(0);
+		map_rom(0x1800, 0x800, rom_size - 0x800);
+	}
+	void tia_write(unsigned short address, unsigned char value) {
+		if ((address & 0x3F) == 0x3F) { select(value % banks); } //$3F is not a TIA register
+	}
+	int state_size() const { return 1; }
+	void save_state(unsigned char* out) const { out[0] = bank; }
+	bool load_state(const unsigned char* in) {
+		if (in[0] >= banks) { return 0; }
+		select(in[0]);
+		return 1;
+	}
+
+private:
+	int banks;
+	int bank;
+	void select(int bank) {
+		map_rom(0x1000, 0x800, bank * 0x800);
+		this->bank = bank;
+	}
+};
+
+// ####### E7 (M-Network): 2K ROM banks or 1K RAM below, a 256-byte RAM window and a fixed top #####
+
+class CartE7 : public Cartridge {
+public:
+	CartE7(RomImage* image, int size, std::string scheme) : Cartridge(image, size, scheme) {
+		memset(ram, 0, sizeof(ram));
+	}
+	void reset() {
+		hook(0x1FC0, MemIO::PAGE_SIZE);
+		map_rom(0x1A00, 0x600, 7 * 0x800 + 0x200); //$1A00-$1FFF, last bank
+		select_low(0);
+		select_window(0);
+	}
+	void hotspot(unsigned short address) {
+		address = address & 0x0FFF;
+		if ((address >= 0x0FE0) && (address <= 0x0FE7)) { select_low(address & 0x07); }
+		else if ((address >= 0x0FE8) && (address <= 0x0FEB)) { select_window(address & 0x03); }
+	}
+
+	int state_size() const { return 2 + sizeof(ram); }
+	void save_state(unsigned char* out) const {
+		out[0] = low_bank;
+		out[1] = window_bank;
+		memcpy(out + 2, ram, sizeof(ram));
+	}
+	bool load_state(const unsigned char* in) {
+		if ((in[0] > 7) || (in[1] > 3)) { return 0; }
+		select_low(in[0]);
+		select_window(in[1]);
+		memcpy(ram, in + 2, sizeof(ram));
+		return 1;
+	}
+
+private:
+	unsigned char ram[2048]; //1K low RAM then four 256-byte window banks
+	int low_bank;
+	int window_bank;
+	void select_low(int bank) {
+		if (bank == 7) { map_ram(0x1400, 0x1000, 0x400, ram); } //write at $1000-$13FF, read at $1400-$17FF
+		else { map_rom(0x1000, 0x800, bank * 0x800); }
+		low_bank = bank;
+	}
+	void select_window(int bank) {
+		map_ram(0x1900, 0x1800, 0x100, ram + 0x400 + bank * 0x100); //write at $1800-$18FF, read at $1900-$19FF
+		window_bank = bank;
+	}
+};
+
+// ####### DPC (Pitfall II): F8 banking plus data fetchers, a random number generator and music #####
+// Music fetchers count at about 20 kHz. Like the RIOT timer they are not ticked, they are brought up to date from the
+// cycle count when the program reads them.
+
+class CartDPC : public CartF8 {
+public:
+	static const int PROGRAM_SIZE = 0x2000;
+	static const int DISPLAY_SIZE = 0x800;
+
+	CartDPC(RomImage* image, int size, std::string scheme) : CartF8(image, PROGRAM_SIZE, scheme, 0x1FF8, 1, 0) {
+		display = image->data + PROGRAM_SIZE;
+	}
+	void reset() {
+		CartF8::reset();
+		hook(0x1000, 0x80); //registers: reads $1000-$103F, writes $1040-$107F
+		memset(&fetchers, 0, sizeof(fetchers)); //padding too, snapshots copy the struct as it is
+		fetchers.random = 1;
+		fetchers.music_cycle = bus->cycles;
+	}
+	unsigned char read(unsigned short address) {
+		if ((address & 0x0FFF) >= 0x40) { return CartF8::read(address); }
+		clock_random();
+		int index = address & 0x07;
+		int function = (address >> 3) & 0x07;
+		unsigned char result = 0;
+		switch (function) {
+		case 0x00:
+			if (index < 4) { result = fetchers.random; }
+			else { //music amplitude from the three music fetchers
+				static const unsigned char amplitudes[8] = { 0x00, 0x04, 0x05, 0x09, 0x06, 0x0A, 0x0B, 0x0F };
+				update_music();
+				int i = 0;
+				if (fetchers.music_mode[0] && fetchers.flags[5]) { i |= 0x01; }
+				if (fetchers.music_mode[1] && fetchers.flags[6]) { i |= 0x02; }
+				if (fetchers.music_mode[2] && fetchers.flags[7]) { i |= 0x04; }
+				result = amplitudes[i];
+			}
+			break;
+		case 0x01: //display data
+			result = display[(DISPLAY_SIZE - 1) - fetchers.counters[index]];
+			break;
+		case 0x02: //display data masked by the fetcher flag
+			result = display[(DISPLAY_SIZE - 1) - fetchers.counters[index]] & fetchers.flags[index];
+			break;
+		case 0x07:
+			result = fetchers.flags[index];
+			break;
+		default:
+			break;
+		}
+		if ((index < 5) || !fetchers.music_mode[index - 5]) { fetchers.counters[index] = (fetchers.counters[index] - 1) & 0x07FF; } //music fetchers count on their own
+		if ((fetchers.counters[index] & 0xFF) == fetchers.tops[index]) { fetchers.flags[index] = 0xFF; }
+		else if ((fetchers.counters[index] & 0xFF) == fetchers.bottoms[index]) { fetchers.flags[index] = 0x00; }
+		return result;
+	}
+	void write(unsigned short address, unsigned char value) {
+		if (((address & 0x0FFF) < 0x40) || ((address & 0x0FFF) >= 0x80)) { CartF8::write(address, value); return; }
+		clock_random();
+		int index = address & 0x07;
+		int function = (address >> 3) & 0x07;
+		switch (function) {
+		case 0x00: //top
+			fetchers.tops[index] = value;
+			fetchers.flags[index] = 0x00;
+			break;
+		case 0x01: //bottom
+			fetchers.bottoms[index] = value;
+			break;
+		case 0x02: //counter low byte
+			fetchers.counters[index] = (fetchers.counters[index] & 0x0700) | value;
+			break;
+		case 0x03: //counter high bits, bit 4 turns music mode on for fetchers 5-7
+			fetchers.counters[index] = ((value & 0x07) << 8) | (fetchers.counters[index] & 0x00FF);
+			if (index >= 5) {
+				update_music();
+				fetchers.music_mode[index - 5] = value & 0x10;
+			}
+			break;
+		case 0x06:
+			fetchers.random = 1;
+			break;
+		default:
+			break;
+		}
+	}
+
+	int state_size() const { return CartF8::state_size() + sizeof(Fetchers); }
+	void save_state(unsigned char* out) const {
+		CartF8::save_state(out);
+		memcpy(out + CartF8::state_size(), &fetchers, sizeof(Fetchers));
+	}
+	bool load_state(const unsigned char* in) {
+		Fetchers loaded;
+		memcpy(&loaded, in + CartF8::state_size(), sizeof(Fetchers));
+		for (int i = 0; i < 8; i++) {
+			if (loaded.counters[i] > 0x07FF) { return 0; } //would index past the display ROM
+		}
+		unsigned char modes[3]; //bools, only 0 and 1 are valid bytes
+		memcpy(modes, in + CartF8::state_size() + offsetof(Fetchers, music_mode), sizeof(modes));
+		if ((modes[0] > 1) || (modes[1] > 1) || (modes[2] > 1)) { return 0; }
+		if (!CartF8::load_state(in)) { return 0; }
+		fetchers = loaded;
+		return 1;
+	}
+
+private:
+	static const unsigned long long CPU_HZ = 1193182;
+	static const unsigned long long MUSIC_HZ = 20000;
+	const unsigned char* display; //2K graphics ROM read through the fetchers, right after the program in the image
+	struct Fetchers { //everything but the banking, kept together so snapshots copy it in one go
+		unsigned char tops[8];
+		unsigned char bottoms[8];
+		unsigned short counters[8]; //11 bits
+		unsigned char flags[8];
+		bool music_mode[3]; //fetchers 5-7
+		unsigned char random;
+		unsigned long long music_cycle; //cycle the music fetchers were last brought up to date
+		unsigned long long music_fraction; //leftover of the cycle to music clock conversion, in units of 1/CPU_HZ
+	};
+	Fetchers fetchers;
+
+	void clock_random() { //8-bit LFSR, taps 7, 5, 4, 3
+		unsigned char taps = fetchers.random & 0xB8;
+		unsigned char parity = 0;
+		while (taps) {
+			parity ^= taps & 1;
+			taps >>= 1;
+		}
+		fetchers.random = (fetchers.random << 1) | (~parity & 0x01);
+	}
+	void update_music() {
+		unsigned long long scaled = (bus->cycles - fetchers.music_cycle) * MUSIC_HZ + fetchers.music_fraction;
+		unsigned long long clocks = scaled / CPU_HZ;
+		fetchers.music_fraction = scaled % CPU_HZ;
+		fetchers.music_cycle = bus->cycles;
+		if (clocks == 0) { return; }
+		for (int x = 5; x < 8; x++) {
+			if (!fetchers.music_mode[x - 5]) { continue; }
+			int top = fetchers.tops[x] + 1;
+			int low = fetchers.counters[x] & 0xFF;
+			if (fetchers.tops[x] != 0) {
+				low = low - (int)(clocks % top);
+				if (low < 0) { low = low + top; }
+			}
+			else { low = 0; }
+			if (low <= fetchers.bottoms[x]) { fetchers.flags[x] = 0x00; }
+			else if (low <= fetchers.tops[x]) { fetchers.flags[x] = 0xFF; }
+			fetchers.counters[x] = (fetchers.counters[x] & 0x0700) | low;
+		}
+	}
+};
+
+// ####### factory #####
+
+std::string Cartridge::default_scheme(int size) {
+	switch (size) {
+	case 0x800:
+		return "2K";
+	case 0x1000:
+		return "4K";
+	case 0x2000:
+		return "F8";
+	case 0x4000:
+		return "F6";
+	case 0x8000:
+		return "F4";
+	default:
+		if (size >= CartDPC::PROGRAM_SIZE + CartDPC::DISPLAY_SIZE && size <= CartDPC::PROGRAM_SIZE + CartDPC::DISPLAY_SIZE + 0x100) { return "DPC"; } //some dumps carry 255 extra bytes
+		return "";
+	}
+}
+
+Cartridge* Cartridge::create(RomImage* image, std::string scheme) {
+	int size = image->size;
+	if (scheme == "2K" && size == 0x800) { return new CartStandard(image, size, scheme); }
+	if (scheme == "4K" && size == 0x1000) { return new CartStandard(image, size, scheme); }
+	if ((scheme == "F8" || scheme == "F8SC") && size == 0x2000) { return new CartF8(image, size, scheme, 0x1FF8, 1, scheme == "F8SC"); }
+	if ((scheme == "F6" || scheme == "F6SC") && size == 0x4000) { return new CartF8(image, size, scheme, 0x1FF6, 0, scheme == "F6SC"); }
+	if ((scheme == "F4" || scheme == "F4SC") && size == 0x8000) { return new CartF8(image, size, scheme, 0x1FF4, 0, scheme == "F4SC"); }
+	if (scheme == "FE" && size == 0x2000) { return new CartFE(image, size, scheme); }
+	if (scheme == "E0" && size == 0x2000) { return new CartE0(image, size, scheme); }
+	if (scheme == "3F" && size >= 0x800 && size <= 0x80000 && (size % 0x800) == 0) { return new Cart3F(image, size, scheme); }
+	if (scheme == "E7" && size == 0x4000) { return new CartE7(image, size, scheme); }
+	if (scheme == "DPC" && size >= CartDPC::PROGRAM_SIZE + CartDPC::DISPLAY_SIZE) { return new CartDPC(image, size, scheme); }
+	std::cerr << "Unsupported cartridge: scheme " << scheme << ", " << size << " bytes" << std::endl;
+	delete image;
+	return NULL;
+}
+
+Cartridge* Cartridge::create(const unsigned char* image, int size, std::string scheme) {
+	return create(RomImage::copy_of(image, size), scheme);
+}
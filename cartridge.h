@@ -0,0 +1,54 @@
+#pragma once
+#define CARTRIDGE_H
+
+#include <string>
+
+#include "memory.h"
+#include "romimage.h"
+
+// Cartridges and their bank-switching schemes. A cartridge never copies ROM around: it borrows the bytes of its
+// RomImage (usually a file mapping) and switching a bank points the bus page tables at another part of them. Pages holding hotspots (or cartridge registers) are hooked, so accesses
+// to them reach read()/write() instead of going straight through a pointer. Everything else stays on the fast path.
+
+class Cartridge {
+public:
+	virtual ~Cartridge();
+	Cartridge(const Cartridge&) = delete;
+	Cartridge& operator=(const Cartridge&) = delete;
+
+	static Cartridge* create(RomImage* image, std::string scheme); //takes ownership of image. NULL (image deleted) if the scheme is unknown or the image size does not suit it
+	static Cartridge* create(const unsigned char* image, int size, std::string scheme); //same, on a copy of the bytes
+	static std::string default_scheme(int size); //usual scheme for an image of that size, "" if none
+
+	void attach(MemIO& mem); //called by MemIO::insert_cartridge, maps the power-on banks
+	virtual void reset() = 0; //power-on bank layout
+
+	virtual unsigned char read(unsigned short address); //hooked pages only, address masked to 13 bits
+	virtual void write(unsigned short address, unsigned char value);
+	virtual void tia_write(unsigned short address, unsigned char value); //only called when watches_tia is set
+	bool watches_tia; //scheme switches banks on writes into TIA space (3F)
+
+	//snapshots, see snapshot.h
+	virtual int state_size() const; //bytes save_state writes: selected banks and cartridge RAM, 0 without banking
+	virtual void save_state(unsigned char* out) const;
+	virtual bool load_state(const unsigned char* in); //remaps the banks as they were when saved, FALSE (nothing changed) if one does not exist in this ROM
+
+	std::string scheme; //name as given to create
+	int rom_size;
+
+protected:
+	Cartridge(RomImage* image, int size, std::string scheme); //size: bytes of the image that are banked ROM
+	RomImage* image; //owned, deleted with the cartridge
+	const unsigned char* rom; //image->data
+	MemIO* bus;
+	const unsigned char* view[64]; //what each 64-byte page of $1000-$1FFF shows, hooked pages included
+	bool hooked[64];
+
+	static const int CART_PAGES = 64;
+	static int cart_page(unsigned short address) { return ((address & MemIO::ADDRESS_MASK) >> MemIO::PAGE_BITS) - CART_PAGES; }
+	void map_rom(unsigned short address, int size, int offset); //show rom[offset...] at [address, address + size)
+	void map_ram(unsigned short read_address, unsigned short write_address, int size, unsigned char* ram); //cartridge RAM, separate read and write ports
+	void hook(unsigned short address, int size); //send accesses to [address, address + size) through read()/write()
+	void unhook(unsigned short address, int size);
+	virtual void hotspot(unsigned short address); //bank switching on an access to a hooked page, default does nothing
+};
@@ -0,0 +1,189 @@
+#include <cstring>
+
+#include "compositor.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define COMPOSITOR_SSE2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2 //MSVC emits AVX2 intrinsics without a per-function target
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static void fill_pf_colors(const CompositeColors& colors, unsigned char* line, int x0, int x1) { //playfield color can differ per half (score mode)
+	int middle = VISIBLE_PIXELS / 2;
+	if (x0 < middle) { memset(line + x0, colors.pf_left, ((x1 < middle) ? x1 : middle) - x0); }
+	if (x1 > middle) { memset(line + ((x0 > middle) ? x0 : middle), colors.pf_right, x1 - ((x0 > middle) ? x0 : middle)); }
+}
+
+static inline void round_span(int width, int& x0, int& x1) { //out to whole vectors, VISIBLE_PIXELS is a multiple of every width
+	x0 = x0 & ~(width - 1);
+	x1 = (x1 + width - 1) & ~(width - 1);
+}
+
+// ####### scalar fallback #####
+
+void composite_scalar(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out) {
+	for (int x = x0; x < x1; x++) {
+		unsigned char pf_color = (x < VISIBLE_PIXELS / 2) ? colors.pf_left : colors.pf_right;
+		unsigned char color = colors.bk;
+		if (colors.pf_priority) { //PF/BL > P0/M0 > P1/M1 > BK
+			if (masks.p1[x] | masks.m1[x]) { color = colors.p1; }
+			if (masks.p0[x] | masks.m0[x]) { color = colors.p0; }
+			if (masks.pf[x]) { color = pf_color; }
+			if (masks.bl[x]) { color = colors.bl; }
+		}
+		else { //P0/M0 > P1/M1 > PF/BL > BK
+			if (masks.pf[x]) { color = pf_color; }
+			if (masks.bl[x]) { color = colors.bl; }
+			if (masks.p1[x] | masks.m1[x]) { color = colors.p1; }
+			if (masks.p0[x] | masks.m0[x]) { color = colors.p0; }
+		}
+		out[x] = color;
+	}
+}
+
+// ####### collisions #####
+
+static const int pair_count = 16;
+static const int pair_objects[pair_count][2] = { //indices into the object list of collide_span, in CollisionPair order
+	{4, 3}, {4, 2}, {5, 2}, {5, 3}, {2, 0}, {2, 1}, {3, 0}, {3, 1},
+	{4, 0}, {4, 1}, {5, 0}, {5, 1}, {1, 0}, {1, 1}, {2, 3}, {4, 5}
+};
+
+unsigned short collide_span(const ObjectMasks& masks, int x0, int x1) {
+	const unsigned char* objects[6] = { masks.pf, masks.bl, masks.p0, masks.p1, masks.m0, masks.m1 };
+	unsigned short pairs = 0;
+	int x = x0;
+#ifdef COMPOSITOR_SSE2
+	__m128i hits[pair_count];
+	for (int p = 0; p < pair_count; p++) { hits[p] = _mm_setzero_si128(); }
+	for (; x + 16 <= x1; x += 16) { //AND every pair over 16 pixels, OR into its accumulator
+		__m128i obj[6];
+		for (int o = 0; o < 6; o++) { obj[o] = _mm_loadu_si128((const __m128i*)(objects[o] + x)); }
+		for (int p = 0; p < pair_count; p++) {
+			hits[p] = _mm_or_si128(hits[p], _mm_and_si128(obj[pair_objects[p][0]], obj[pair_objects[p][1]]));
+		}
+	}
+	for (int p = 0; p < pair_count; p++) {
+		if (_mm_movemask_epi8(hits[p]) != 0) { pairs |= 1 << p; }
+	}
+#endif
+	for (; x < x1; x++) { //span tail (or the whole span without SSE2)
+		for (int p = 0; p < pair_count; p++) {
+			if (objects[pair_objects[p][0]][x] & objects[pair_objects[p][1]][x]) { pairs |= 1 << p; }
+		}
+	}
+	return pairs & ~(1 << CX_UNUSED);
+}
+
+#ifdef COMPOSITOR_SSE2
+
+// ####### SSE2, 16 pixels per step #####
+
+static inline __m128i select16(__m128i mask, __m128i color, __m128i below) { //color where mask is set, below elsewhere
+	return _mm_or_si128(_mm_and_si128(mask, color), _mm_andnot_si128(mask, below));
+}
+
+void composite_sse2(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out) {
+	round_span(16, x0, x1);
+	alignas(16) unsigned char pf_line[VISIBLE_PIXELS];
+	fill_pf_colors(colors, pf_line, x0, x1);
+	const __m128i bk = _mm_set1_epi8((char)colors.bk);
+	const __m128i bl = _mm_set1_epi8((char)colors.bl);
+	const __m128i p0 = _mm_set1_epi8((char)colors.p0);
+	const __m128i p1 = _mm_set1_epi8((char)colors.p1);
+	for (int x = x0; x < x1; x += 16) {
+		__m128i pf_color = _mm_loadu_si128((const __m128i*)(pf_line + x));
+		__m128i m_pf = _mm_loadu_si128((const __m128i*)(masks.pf + x));
+		__m128i m_bl = _mm_loadu_si128((const __m128i*)(masks.bl + x));
+		__m128i m_p0 = _mm_or_si128(_mm_loadu_si128((const __m128i*)(masks.p0 + x)), _mm_loadu_si128((const __m128i*)(masks.m0 + x)));
+		__m128i m_p1 = _mm_or_si128(_mm_loadu_si128((const __m128i*)(masks.p1 + x)), _mm_loadu_si128((const __m128i*)(masks.m1 + x)));
+		__m128i color = bk;
+		if (colors.pf_priority) {
+			color = select16(m_p1, p1, color);
+			color = select16(m_p0, p0, color);
+			color = select16(m_pf, pf_color, color);
+			color = select16(m_bl, bl, color);
+		}
+		else {
+			color = select16(m_pf, pf_color, color);
+			color = select16(m_bl, bl, color);
+			color = select16(m_p1, p1, color);
+			color = select16(m_p0, p0, color);
+		}
+		_mm_storeu_si128((__m128i*)(out + x), color);
+	}
+}
+
+// ####### AVX2, 32 pixels per step #####
+
+TARGET_AVX2 void composite_avx2(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out) {
+	round_span(32, x0, x1);
+	alignas(32) unsigned char pf_line[VISIBLE_PIXELS];
+	fill_pf_colors(colors, pf_line, x0, x1);
+	const __m256i bk = _mm256_set1_epi8((char)colors.bk);
+	const __m256i bl = _mm256_set1_epi8((char)colors.bl);
+	const __m256i p0 = _mm256_set1_epi8((char)colors.p0);
+	const __m256i p1 = _mm256_set1_epi8((char)colors.p1);
+	for (int x = x0; x < x1; x += 32) {
+		__m256i pf_color = _mm256_loadu_si256((const __m256i*)(pf_line + x));
+		__m256i m_pf = _mm256_loadu_si256((const __m256i*)(masks.pf + x));
+		__m256i m_bl = _mm256_loadu_si256((const __m256i*)(masks.bl + x));
+		__m256i m_p0 = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(masks.p0 + x)), _mm256_loadu_si256((const __m256i*)(masks.m0 + x)));
+		__m256i m_p1 = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(masks.p1 + x)), _mm256_loadu_si256((const __m256i*)(masks.m1 + x)));
+		__m256i color = bk;
+		if (colors.pf_priority) {
+			color = _mm256_blendv_epi8(color, p1, m_p1);
+			color = _mm256_blendv_epi8(color, p0, m_p0);
+			color = _mm256_blendv_epi8(color, pf_color, m_pf);
+			color = _mm256_blendv_epi8(color, bl, m_bl);
+		}
+		else {
+			color = _mm256_blendv_epi8(color, pf_color, m_pf);
+			color = _mm256_blendv_epi8(color, bl, m_bl);
+			color = _mm256_blendv_epi8(color, p1, m_p1);
+			color = _mm256_blendv_epi8(color, p0, m_p0);
+		}
+		_mm256_storeu_si256((__m256i*)(out + x), color);
+	}
+}
+
+static bool host_has_avx2() {
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 1);
+	bool osxsave = regs[2] & (1 << 27);
+	bool avx = regs[2] & (1 << 28);
+	if (!(osxsave && avx)) { return 0; }
+	if ((_xgetbv(0) & 0x6) != 0x6) { return 0; } //OS must save the YMM registers
+	__cpuidex(regs, 7, 0);
+	return regs[1] & (1 << 5);
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+CompositeFn select_compositor() {
+	if (host_has_avx2()) { return composite_avx2; }
+	return composite_sse2; //always there on x86-64
+}
+
+#else // no x86 SIMD, both wide kernels fall back to the scalar one
+
+void composite_sse2(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out) {
+	composite_scalar(masks, colors, x0, x1, out);
+}
+
+void composite_avx2(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out) {
+	composite_scalar(masks, colors, x0, x1, out);
+}
+
+CompositeFn select_compositor() {
+	return composite_scalar;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#define COMPOSITOR_H
+
+// Scanline compositor: resolves TIA object priority and colors for a span of the 160-pixel line at once.
+// Every object is given as a byte mask (0xFF where the object is drawn), so the kernels are plain bitwise selects
+// that SSE2/AVX2 can do 16/32 pixels at a time. The kernel is picked once at startup from what the host CPU supports.
+
+static const int VISIBLE_PIXELS = 160; //visible color clocks per scanline, a multiple of 32
+
+struct ObjectMasks { //one byte per visible pixel, 0xFF if the object covers it. Kernels use unaligned loads, no alignment required
+	unsigned char pf[VISIBLE_PIXELS]; //playfield
+	unsigned char bl[VISIBLE_PIXELS]; //ball
+	unsigned char p0[VISIBLE_PIXELS]; //player 0
+	unsigned char p1[VISIBLE_PIXELS]; //player 1
+	unsigned char m0[VISIBLE_PIXELS]; //missile 0
+	unsigned char m1[VISIBLE_PIXELS]; //missile 1
+};
+
+struct CompositeColors { //color registers and priority as they are for the span being drawn
+	unsigned char bk; //COLUBK
+	unsigned char pf_left; //playfield color, left half (COLUPF, or COLUP0 in score mode)
+	unsigned char pf_right; //playfield color, right half (COLUPF, or COLUP1 in score mode)
+	unsigned char bl; //COLUPF
+	unsigned char p0; //COLUP0, player and missile 0
+	unsigned char p1; //COLUP1, player and missile 1
+	bool pf_priority; //CTRLPF bit 2, playfield and ball drawn over the players
+};
+
+//writes the color codes of visible pixels [x0, x1) to out[x0..x1). The SIMD kernels round the span out to their vector
+//width, so out must have room for VISIBLE_PIXELS and the pixels just outside the span may be overwritten
+typedef void (*CompositeFn)(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out);
+
+void composite_scalar(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out);
+void composite_sse2(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out);
+void composite_avx2(const ObjectMasks& masks, const CompositeColors& colors, int x0, int x1, unsigned char* out);
+CompositeFn select_compositor(); //widest kernel the host supports, scalar if none
+
+enum CollisionPair { //bit numbers of the collide_span result. Pair 2n is bit 7 and pair 2n+1 bit 6 of latch CXM0P+n
+	CX_M0P1, CX_M0P0, //CXM0P
+	CX_M1P0, CX_M1P1, //CXM1P
+	CX_P0PF, CX_P0BL, //CXP0FB
+	CX_P1PF, CX_P1BL, //CXP1FB
+	CX_M0PF, CX_M0BL, //CXM0FB
+	CX_M1PF, CX_M1BL, //CXM1FB
+	CX_BLPF, CX_UNUSED, //CXBLPF, bit 6 unused
+	CX_P0P1, CX_M0M1 //CXPPMM
+};
+
+unsigned short collide_span(const ObjectMasks& masks, int x0, int x1); //bit set for every CollisionPair overlapping in visible pixels [x0, x1)
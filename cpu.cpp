@@ -1,15 +1,13 @@
 #include <iostream>
+#include <cstring>
 
 #include "cpu.h"
+#include "jit.h"
 
 
 
 
 // #### RANDOM USEFUL FUNCTIONS ####
-bool isNegative_8b(unsigned char value) {
-	char x = value;
-	return (x < 0);
-}
 
 unsigned short concatenate2x8b(unsigned char low_b, unsigned char high_b) {
 	unsigned short res = (high_b << 8) | low_b;
@@ -38,7 +36,7 @@ bool crossing_page_notconcatenated(unsigned char low, unsigned char high, unsign
 	else { return 1; } //page crossed, may need extra cycle
 }
 
-bool crossing_page_jump(unsigned short PC, char offset) { //checks to see if jump target is outside of current page
+bool crossing_page_jump(unsigned short PC, signed char offset) { //checks to see if jump target is outside of current page
 	unsigned char upper = PC >> 8;
 	unsigned short res = PC + offset;
 	unsigned char res_upper = res >> 8; //upper byte of target PC
@@ -48,32 +46,146 @@ bool crossing_page_jump(unsigned short PC, char offset) { //checks to see if jum
 
 // ##### MAIN CPU LOOP ######
 
-void Processor::cpu_tick(MemIO mem) { //main loop for CPU
+void Processor::cpu_tick(MemIO& mem) { //main loop for CPU
 	// at beginning of cycle, 6502 state is defined
-	unsigned char opcode = mem.read(PC); //get current opcode from current PC
 	if (waiting == 0) { //if processor is currently active (not RDY state)
 		if (step > 0) { //cpu currently doing something, wait to next cycle. Using > instead of != in case counter somehow goes under 0
 			wait();
 		}
 		else { //main processing loop, CPU starts up a new instruction
-			printf("Opcode: %x ; PC: %x ; step: %d ; registers A:%d; X:%d; Y:%d ; flags N:%d Z:%d, C:%d, I:%d, D:%d, V:%d, SP: %x \n", opcode, PC, step, A, X, Y, N, Z, C, I, D, V, SP);
-			compute(opcode, mem); //perform the instruction and modify state
+			compute(mem); //perform the instruction and modify state
+			if (mem.cpu_waiting) { //instruction strobed WSYNC
+				step = step + halt_until_hblank(mem);
+				sleep();
+			}
 		}
 	}
-	else { //RDY state
-
+	else { //RDY state, burning the cycles left on the scanline
+		wait();
+		if (step <= 0) { wake(); }
 	}
 
 
 }
 
+unsigned long long Processor::run_cycles(MemIO& mem, unsigned long long budget) { //batch entry point, whole instructions back to back
+	unsigned long long start = mem.cycles;
+	unsigned long long end = start + budget;
+	skip_limit = end;
+	while (mem.cycles < end) {
+		run_block(mem, end); //cost goes straight onto the system clock, no per-cycle bookkeeping
+		if (mem.cpu_waiting) { halt_until_hblank(mem); } //WSYNC
+	}
+	skip_limit = 0;
+	return mem.cycles - start; //may overshoot the budget by the tail of the last instruction
+}
+
+bool Processor::run_until_frame(MemIO& mem) {
+	unsigned long long end = mem.cycles + MemIO::MAX_FRAME_CYCLES; //bail out if the program never starts VSYNC
+	mem.frame_ready = 0;
+	skip_limit = end;
+	while (!mem.frame_ready && (mem.cycles < end)) {
+		run_block(mem, end);
+		if (mem.cpu_waiting) { halt_until_hblank(mem); }
+	}
+	skip_limit = 0;
+	bool done = mem.frame_ready;
+	mem.frame_ready = 0; //frame consumed
+	return done;
+}
+
 // ####### aux methods for CPU #####
 
-Processor::Processor(MemIO mem) { //constructor
+Processor::Processor(MemIO& mem) { //constructor
+	trace = NULL; //tracing off until a buffer is attached
+	illegal_count = 0;
+	idle_skip = 1;
+	skip_limit = 0; //cycle-stepped cpu_tick never skips, only the batch entry points allow it
+	decoded = new DecodedOp[DECODE_SLOTS];
+	blocks = new CodeBlock[DECODE_SLOTS];
+	jit = NULL;
+	drop_caches(mem); //every slot decodes on first use
 	Processor::reset(mem);//reset at system startup
 }
 
-void Processor::reset(MemIO mem) { //reset state to startup
+Processor::~Processor() {
+	delete[] decoded;
+	delete[] blocks;
+	delete jit;
+}
+
+void Processor::drop_caches(MemIO& mem) {
+	for (int i = 0; i < IDLE_SLOTS; i++) {
+		idle_loops[i].branch_pc = 0;
+		idle_loops[i].head = 0;
+		idle_loops[i].generation = 0;
+		idle_loops[i].pages.count = 0;
+	}
+	for (int i = 0; i < DECODE_SLOTS; i++) {
+		decoded[i].generation = 0;
+		blocks[i].generation = 0;
+		blocks[i].pages.count = 0;
+	}
+	if (jit != NULL) { jit->flush(); }
+	cache_epoch = mem.cache_epoch;
+}
+
+bool Processor::PageSet::add(unsigned short first, int size) {
+	for (int p = first >> MemIO::PAGE_BITS; p <= (first + size - 1) >> MemIO::PAGE_BITS; p++) {
+		bool known = 0;
+		for (int i = 0; i < count; i++) {
+			if (page[i] == (p & (MemIO::PAGE_COUNT - 1))) { known = 1; }
+		}
+		if (known) { continue; }
+		if (count >= MAX) { return 0; }
+		page[count] = p & (MemIO::PAGE_COUNT - 1);
+		count = count + 1;
+	}
+	return 1;
+}
+
+void Processor::set_trace(TraceBuffer* buffer) {
+	trace = buffer;
+}
+
+void Processor::set_idle_skip(bool enabled) {
+	idle_skip = enabled;
+}
+
+void Processor::set_jit(bool enabled) {
+	delete jit;
+	jit = NULL;
+#ifdef JIT_X64
+	if (enabled) { jit = new JitCache(); }
+#else
+	(void)enabled;
+#endif
+}
+
+void Processor::save_state(CpuState& state) const {
+	state.PC = PC;
+	state.A = A;
+	state.X = X;
+	state.Y = Y;
+	state.SP = SP;
+	state.SR = SR();
+	state.waiting = waiting;
+	state.step = step;
+}
+
+void Processor::load_state(const CpuState& state) {
+	PC = state.PC;
+	A = state.A;
+	X = state.X;
+	Y = state.Y;
+	SP = state.SP;
+	unpack_SR(state.SR);
+	waiting = state.waiting;
+	step = state.step;
+	for (int i = 0; i < IDLE_SLOTS; i++) { idle_loops[i].armed = 0; } //the pass seen before belongs to another timeline
+}
+
+void Processor::reset(MemIO& mem) { //reset state to startup
 	//initialising registers
 	A = 0;
 	X = 0;
@@ -82,15 +194,15 @@ void Processor::reset(MemIO mem) { //reset state to startup
 	//PC fetches from top of reset vectors at $FFFC/$FFFD
 	unsigned char low = mem.read(0xFFFC);
 	unsigned char high = mem.read(0xFFFD);
-	//PC = concatenate2x8b(low, high); //place to start from at system reset
-	//printf("%x \n", PC);
-	PC = 0xF000; //pending 
+	PC = concatenate2x8b(low, high); //place to start from at system reset, in the cartridge's power-on bank
 	D = 0;
-	Z = 0;
+	Z_result = 1; //Z clear
 	C = 1;
-	N = 0;
+	N_result = 0;
 	V = 0;
 	I = 1;
+	B_h = 1; //bits 4 and 5 are not latched on the 6502, they read as 1 when SR is pushed
+	B_l = 1;
 	//resetting program flags
 	step = 0; //currently no in-progress operations
 	waiting = 0;
@@ -100,2249 +212,912 @@ void Processor::wait() { //new system clock tick, instruction has yet to finish
 	step = step - 1; //advancing one clock tick
 }
 
+void Processor::sleep() { //RDY pulled low by the TIA
+	waiting = 1;
+}
 
-void Processor::compute(unsigned char opcode, MemIO mem){ // we have a valid opcode and the processor is expected to work (last clock tick)
-	//value declaration
-	unsigned char imm; // an operand to an instruction
-	unsigned char low, high; // the lower-most and upper-most bytes of a 16-bit value (usually an address)
-	unsigned short val_ptr, add_ptr; // resp: 16 pointer to the operand (imm) and pointer to said pointer (for indirect addressing modes)
-	unsigned char val_ptr_zp, add_ptr_zp; //8-bit pointer used for zeropage operations. We specifically WANT an overflow to happen if $P + X > 255, so we're not using a short like with the other pointer
-	unsigned int Ap; // temporary storage space for arithmetic operation results where overflow won't happen. If overflow happens when carrying over to 8 bits the value of A and Ap will be different
-	char offset; // an 8bit signed offset for use by relative-mode instructions
-
-	unsigned char SR_backup; //place to store the packed flag bits of the 6502 status register
-	unsigned short PC_backup; //place to store a current/future PC value for use in instruction such as BRK
-
-	bool PC_cross_PB, Cp; //flag if PC has crossed page boundary post jump, temporary carry flag when needing to store pre-instruction state
-	switch (opcode) {
-	/*########################### Add with Carry(ADC) ######################################## */
-
-	case 0x69: //ADC immediate, 2b 2c
-		step = 2; //setting cycle length
-		imm = mem.read(PC + 1); //the instruction operand immediately after opc
-		//main artihmetic block
-		Ap = A + imm + C; // doing operation without risk of overflow
-		A = Ap; // casting uint to uchar, may overflow. Different values if overflow.
-		//updating flags
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes, procede to next step
-		PC = PC + 2;
-		step = step - 1;
-		break; //done
-	
-	case 0x65: //ADC zeropage, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1); //address (8b) of operand 
-		imm = mem.read(val_ptr_zp);
-		Ap = A + imm + C; //placeholder value before overflow
-		A = Ap; //casting to word size
-		//updating flags;
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes
-		PC = PC + 2;
-		step = step - 1; 
-		break; 
-
-	case 0x75: //ADC zeropage X, 2b 4c;
-		step = 4;
-		//fetching operand
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp);
-		//main arithmetic
-		Ap = A + imm + C;
-		A = Ap;
-		//flags
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes
-		PC = PC + 2;
-		step = step - 1;
-		break;
-	
-	case 0x6D: // ADC absolute, 3b 4c
-		step = 4;
-		//fetching high and low address bytes
-		low = mem.read(PC + 1); //Little endian !
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		//doing arithmetic
-		Ap = A + imm + C;
-		A = Ap;
-		//flags
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x7D: //ADC absolute,X 3b 4c+
-		step = 4; //may take more, ignoring for now;
-		low = mem.read(PC + 1); //Little endian !
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X;
-		imm = mem.read(val_ptr);
-		//doing arithmetic
-		Ap = A + imm + C;
-		A = Ap;
-		//flags
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-	
-	case 0x79: //ADC absolute, Y, 3b 4c;
-		step = 4; //may take more, ignoring for now;
-		low = mem.read(PC + 1); //Little endian !
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + Y;
-		imm = mem.read(val_ptr);
-		//doing arithmetic
-		Ap = A + imm + C;
-		A = Ap;
-		//flags
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	case 0x61: // ADC pre-indirect ZP, X, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X; //address to value pointer bytes
-		low = mem.read(add_ptr_zp); // low byte of value pointer (LE!)
-		high = mem.read(add_ptr_zp+1); //high byte of value pointer (LE!)
-		val_ptr = concatenate2x8b(low, high); //full address of operand
-		imm = mem.read(val_ptr); //operand
-		//doing arithmetic
-		Ap = A + imm + C;
-		A = Ap;
-		//flags
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes
-		PC = PC + 2;
-		step = step - 1;
-		break;
-	
-	case 0x71: //ADC post-indirect ZP, Y, 2b 5c+
-		step = 5;
-		add_ptr_zp = mem.read(PC + 1); //address in zero page containing pointer
-		low = mem.read(add_ptr_zp); // low byte of value pointer at previously determined address
-		high = mem.read(add_ptr_zp + 1); //high byte of value pointer right after low byte in memory
-		val_ptr = concatenate2x8b(low, high) + Y; //final address of operand
-		imm = mem.read(val_ptr);
-		//doing arithmetic
-		Ap = A + imm + C;
-		A = Ap;
-		//flags
-		N = isNegative_8b(A);
-		Z = (A == 0); //checking if new A value is zero
-		C = (A != Ap); // if sum of two 8bit nbrs does not fit in 8 bits, the actual result will be different from the "real" mathematical result (contained in int)
-		V = (isNegative_8b(A) && isNegative_8b(imm)); //signed overflow happens if two numbers have same sign bit. 
-		//instruction finishes
-		PC = PC + 2;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	/*################################ AND Memory with Accumulator (AND) #####################*/
-
-	case 0x29: // AND imm, 2b 2c
-		step = 2;
-		// logic ops
-		imm = mem.read(PC + 1); //getting value from memory
-		A = A & imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0); 
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x25: //AND Zeropage, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp);
-		A = A & imm; 
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x35: //AND Zeropage X, 2b 4c
-		step = 4;
-		//getting values from memory
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp);
-		A = A & imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x2D: //AND absolute 3b 4c
-		step = 4;
-		low = mem.read(PC + 1); //getting low byte of address in instruction
-		high = mem.read(PC + 2); //getting high byte
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		//op
-		A = A & imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x3D: //AND absolute X, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1); //getting low byte of address in instruction
-		high = mem.read(PC + 2); //getting high byte
-		val_ptr = concatenate2x8b(low, high) + X;
-		imm = mem.read(val_ptr);
-		//op
-		A = A & imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-
-	case 0x39: // AND absolute Y, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1); //getting low byte of address in instruction
-		high = mem.read(PC + 2); //getting high byte
-		val_ptr = concatenate2x8b(low, high) + Y;
-		imm = mem.read(val_ptr);
-		//op
-		A = A & imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	case 0x21: //AND pre-indirect X, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X; //address of pointer to operand
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		//op
-		A = A & imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x31: // AND post-indirect X 2b 5c+
-		step = 5;
-		add_ptr_zp = mem.read(PC + 1); //address of pointer in ZP and instruction
-		//getting contents of last pointer
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high) + Y; // pointer to value with offset
-		imm = mem.read(val_ptr);
-		//op
-		A = A & imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	/* ############################ Shift left one bit (ASL) ###############################*/
-
-	case 0x0A: // ASL Acc, 1b 2c
-		step = 2;
-		C = A & 0x80; // keeping the last bit for the carry flag (hint: 0x80 is binary 1000 0000)
-		A = A << 1; //new result
-		//other flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0x06: //ASL zeropage, 2b 5c;
-		step = 5;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp);
-		C = imm & 0x80; //keeping MSB
-		//op
-		imm = imm << 1;
-		//other flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//writing back to source memory address
-		mem.write(val_ptr_zp, imm); //writeback complete !
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x16: //ASL zeropage X, 2b 6c;
-		step = 6;
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp);
-		C = imm & 0x80; //keeping MSB
-		//op
-		imm = imm << 1;
-		//other flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//writing back to source memory address
-		mem.write(val_ptr_zp, imm); //writeback complete !
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x0E: // ASL absolute, 3b 6c
-		step = 6;
-		//getting address of operand
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		//operations
-		C = imm & 0x80; //keeping MSB
-		imm = imm << 1; 
-		//other flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//writing back to source memory address
-		mem.write(val_ptr, imm); //writeback complete !
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x1E: // ASL absolute X, 3b 7c
-		step = 7;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X;
-		imm = mem.read(val_ptr);
-		//operations
-		C = imm & 0x80; //keeping MSB
-		imm = imm << 1;
-		//other flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//writing back to source memory address
-		mem.write(val_ptr, imm); //writeback complete !
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	/* ########### Branch on carry clear (BCC) #############*/
-
-	case 0x90: // BCC relative, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1);
-		if (C == 0) {
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			// calculating new target address
-			PC = PC + offset + 2; //jumping to target
+void Processor::wake() {
+	waiting = 0;
+}
 
-		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
-		}
-		step = step - 1 + PC_cross_PB; //if original PC + target  jumps to other page, extra cycle taken
-		break;
-	
-	/* ########### Branch on carry set (BCS) #############*/
-
-	case 0xB0: // BCS relative, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1);
-		if (C == 1) {
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			// calculating new target address
-			PC = PC + offset +2; //jumping to target
-		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
-		}
-		step = step - 1 + PC_cross_PB; //if original PC + target  jumps to other page, extra cycle taken
-		break;
+int Processor::halt_until_hblank(MemIO& mem) { //WSYNC: skip the clock to the start of the next scanline, returns cycles spent halted
+	unsigned long long line_end = (mem.cycles + MemIO::CYCLES_PER_SCANLINE - 1) / MemIO::CYCLES_PER_SCANLINE * MemIO::CYCLES_PER_SCANLINE;
+	int stall = line_end - mem.cycles;
+	mem.cycles = line_end;
+	mem.cpu_waiting = 0; //strobe handled
+	return stall;
+}
 
-	/* ###### Branch on result Zero (BEQ) ########*/
 
-	case 0xF0: //BEQ relative, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1);
-		if (Z == 1) { //previous result is zero, branch
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			PC = PC + offset + 2;
-		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
-		}
-		step = step - 1 + PC_cross_PB; //if original PC + target  jumps to other page, extra cycle taken
-		break;
-
-	/* ######## Test Bits in Memory with accumulator (BIT) #############*/
-
-	case 0x24: // BIT zeropage, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp);
-		//updating flags
-		N = A & 0x80;
-		V = A & 0x40;
-		Z = A && imm;
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x2C: //BIT absolute, 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); //address of operand
-		imm = mem.read(val_ptr);
-		//updating flags
-		N = A & 0x80;
-		V = A & 0x40;
-		Z = A && imm;
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	/* #################### Branch on result Minus (BMI) ########## */
-	
-	case 0x30: //BMI relative, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1);
-		if (N == 1) { //if previous result is negative
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			PC = PC + offset + 2;
-			
-		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
-		}
-		step = step - 1 + PC_cross_PB;
-		break;
+void Processor::compute(MemIO& mem){ // we have a valid opcode and the processor is expected to work (last clock tick)
+	step = execute(mem) - 1; //first cycle is the current one
+}
+
+static const unsigned char OPCODE_JSR = 0x20; //fetches its own operand, see op_JSR
+
+int Processor::execute(MemIO& mem) { //runs the instruction at PC and advances the system clock, returns its cycle count
+	unsigned short address = PC & MemIO::ADDRESS_MASK;
+	if (address & 0x1000) { //cartridge space, ROM instructions come from the decode cache
+		if (cache_epoch != mem.cache_epoch) { drop_caches(mem); }
+		DecodedOp& d = decoded[address & (DECODE_SLOTS - 1)];
+		if (stale(mem, address, d)) { decode(mem, address, d); } //first run here, or banks moved since
+		if (d.handler != NULL) { return run_decoded(mem, d); }
+	}
+	unsigned char opcode = mem.read(PC); //get current opcode from current PC
+	const OpInfo& op = op_table[opcode]; //decoding through the dispatch table, see bottom of file
+#ifdef CPU_TRACE
+	if (trace != NULL) { //runtime toggle, one binary record per instruction
+		TraceRecord record;
+		record.cycle = mem.cycles;
+		record.PC = PC;
+		record.opcode = opcode;
+		record.A = A;
+		record.X = X;
+		record.Y = Y;
+		record.SP = SP;
+		record.SR = SR();
+		trace->push(record);
+	}
+#endif
+	extra_cycles = 0;
+	mem.cycles = mem.cycles + op.cycles; //bus accesses see the clock at the end of the instruction, when the 6502 does its write
+	operand = 0;
+	if ((op.bytes > 1) && (opcode != OPCODE_JSR)) { operand = mem.read(PC + 1); }
+	if ((op.bytes > 2) && (opcode != OPCODE_JSR)) { operand = operand | (mem.read(PC + 2) << 8); }
+	PC = PC + op.bytes; //handlers start with PC on the next instruction
+	(this->*op.handler)(mem, op); //perform the instruction and modify state
+	mem.cycles = mem.cycles + extra_cycles;
+	return op.cycles + extra_cycles;
+}
+
+void Processor::decode(MemIO& mem, unsigned short address, DecodedOp& d) { //address masked, in cartridge space
+	d.generation = mem.map_generation;
+	d.handler = NULL;
+	unsigned char opcode = mem.read(address);
+	const OpInfo& op = op_table[opcode];
+	d.bytes = op.bytes; //pages to check next time, even when not cacheable
+	for (int i = 0; i < op.bytes; i++) { //every byte on plain ROM, a hotspot among them has to be read at run time
+		unsigned short byte_address = (address + i) & MemIO::ADDRESS_MASK;
+		if (mem.page_device[byte_address >> MemIO::PAGE_BITS] != MemIO::DEV_ROM) { return; }
+	}
+	d.opcode = opcode;
+	d.cycles = op.cycles;
+	d.operand = 0;
+	if (op.bytes > 1) { d.operand = mem.read(address + 1); }
+	if (op.bytes > 2) { d.operand = d.operand | (mem.read(address + 2) << 8); }
+	d.handler = op.handler;
+}
+
+int Processor::run_decoded(MemIO& mem, const DecodedOp& d) {
+#ifdef CPU_TRACE
+	if (trace != NULL) {
+		TraceRecord record;
+		record.cycle = mem.cycles;
+		record.PC = PC;
+		record.opcode = d.opcode;
+		record.A = A;
+		record.X = X;
+		record.Y = Y;
+		record.SP = SP;
+		record.SR = SR();
+		trace->push(record);
+	}
+#endif
+	extra_cycles = 0;
+	mem.cycles = mem.cycles + d.cycles;
+	operand = d.operand;
+	PC = PC + d.bytes;
+	(this->*d.handler)(mem, op_table[d.opcode]); //straight to the handler, the table entry is only passed along
+	mem.cycles = mem.cycles + extra_cycles;
+	return d.cycles + extra_cycles;
+}
+
+// ####### addressing modes #####
+// One specialisation per mode: the handler templates below pick theirs at compile time, so no handler tests its mode at run time.
+
+constexpr bool has_page_penalty(AddrMode mode) { //indexed reads take an extra cycle when the index carries into the high byte
+	return (mode == AddrMode::ABSX) || (mode == AddrMode::ABSY) || (mode == AddrMode::INDY);
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::ZP>(MemIO& mem) {
+	return (unsigned char)operand;
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::ZPX>(MemIO& mem) {
+	return (unsigned char)(operand + X); //8-bit pointer, we specifically WANT an overflow to happen if $P + X > 255
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::ZPY>(MemIO& mem) {
+	return (unsigned char)(operand + Y);
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::ABS>(MemIO& mem) {
+	return operand;
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::ABSX>(MemIO& mem) {
+	page_crossed = crossing_page_boundary(operand, X);
+	return operand + X;
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::ABSY>(MemIO& mem) {
+	page_crossed = crossing_page_boundary(operand, Y);
+	return operand + Y;
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::IND>(MemIO& mem) { //JMP only. The 6502 never carries into the high byte when fetching the pointer (JMP ($xxFF) bug)
+	unsigned char low = mem.read(operand);
+	unsigned char high = mem.read((operand & 0xFF00) | ((operand + 1) & 0x00FF));
+	return concatenate2x8b(low, high);
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::INDX>(MemIO& mem) { //pre-indexed indirect, pointer stays in zero page
+	unsigned char add_ptr_zp = operand + X;
+	unsigned char low = mem.read(add_ptr_zp);
+	unsigned char high = mem.read((unsigned char)(add_ptr_zp + 1));
+	return concatenate2x8b(low, high);
+}
+
+template<> unsigned short Processor::operand_address<AddrMode::INDY>(MemIO& mem) { //post-indexed indirect
+	unsigned char add_ptr_zp = operand;
+	unsigned char low = mem.read(add_ptr_zp);
+	unsigned char high = mem.read((unsigned char)(add_ptr_zp + 1));
+	page_crossed = crossing_page_notconcatenated(low, high, Y);
+	return concatenate2x8b(low, high) + Y;
+}
+
+template<AddrMode M> unsigned char Processor::fetch_operand(MemIO& mem) {
+	unsigned short address = operand_address<M>(mem);
+	if (has_page_penalty(M)) { //folded away for every other mode
+		extra_cycles = extra_cycles + page_crossed;
+	}
+	return mem.read(address);
+}
+
+template<> unsigned char Processor::fetch_operand<AddrMode::IMM>(MemIO& mem) { //the value came with the instruction
+	return (unsigned char)operand;
+}
 
-	/* ######## Branch on result not Zero (BNE) #######*/
+// ####### basic blocks #####
+// Blocks are built lazily, one per start address, and go stale with the decode cache on any remap. The run loops only
+// enter a block when its worst case ends inside their budget, so they stop on the same instruction as before.
+
+static bool ends_block(const OpInfo& op) { //control transfers and stack users, whatever their operands
+	static const char* enders[] = { "BRK", "JMP", "JSR", "RTI", "RTS", "PHA", "PHP", "PLA", "PLP", "???" }; //stack page is half TIA
+	if (op.mode == AddrMode::REL) { return 1; }
+	for (unsigned int i = 0; i < sizeof(enders) / sizeof(enders[0]); i++) {
+		if (strcmp(op.mnemonic, enders[i]) == 0) { return 1; }
+	}
+	return 0;
+}
 
-	case 0xD0: // BNE relative, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1);
-		if (Z == 0) { //result not zero
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			PC = PC + offset +2;
+static bool plain_memory(const MemIO& mem, unsigned short first, int size) { //[first, first + size) only reaches RAM and ROM pages
+	for (int page = first >> MemIO::PAGE_BITS; page <= (first + size - 1) >> MemIO::PAGE_BITS; page++) {
+		MemIO::Device device = mem.page_device[page & (MemIO::PAGE_COUNT - 1)];
+		if ((device != MemIO::DEV_MEMORY) && (device != MemIO::DEV_ROM)) { return 0; }
+	}
+	return 1;
+}
+
+void Processor::build_block(MemIO& mem, unsigned short address, CodeBlock& b) { //address masked, in cartridge space
+	b.generation = mem.map_generation;
+	b.pages.count = 0;
+	b.cycles = 0;
+	b.crossings = 0;
+	b.count = 0;
+	while (b.count < BLOCK_MAX_OPS) {
+		DecodedOp& d = decoded[address & (DECODE_SLOTS - 1)];
+		if (stale(mem, address, d)) { decode(mem, address, d); }
+		if (!b.pages.add(address, d.bytes)) { return; } //depends on more pages than it can track, stop before it
+		if (d.handler == NULL) { return; } //left for execute(), the block stops before it
+		const OpInfo& op = op_table[d.opcode];
+		bool last;
+		switch (op.mode) {
+		case AddrMode::IMP: case AddrMode::ACC: case AddrMode::IMM:
+			last = ends_block(op);
+			break;
+		case AddrMode::ZP: case AddrMode::ABS:
+			if (!b.pages.add(d.operand & MemIO::ADDRESS_MASK, 1)) { return; }
+			last = ends_block(op) || !plain_memory(mem, d.operand & MemIO::ADDRESS_MASK, 1);
+			break;
+		case AddrMode::ABSX: case AddrMode::ABSY: //any index, ROM tables and RAM arrays stay inside
+			if (!b.pages.add(d.operand & MemIO::ADDRESS_MASK, 0x100)) { return; }
+			last = !plain_memory(mem, d.operand & MemIO::ADDRESS_MASK, 0x100);
+			break;
+		default: //zero page indexing can wrap into the TIA, indirect targets are unknown
+			last = 1;
 		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
+		b.cycles = b.cycles + d.cycles;
+		b.crossings = b.crossings + has_page_penalty(op.mode);
+		b.count = b.count + 1;
+		address = address + d.bytes;
+		if (last || !(address & 0x1000)) { return; } //also ran off the top of cartridge space
+	}
+}
+
+void Processor::run_block(MemIO& mem, unsigned long long end) {
+	unsigned short address = PC & MemIO::ADDRESS_MASK;
+	if (address & 0x1000) {
+		if (cache_epoch != mem.cache_epoch) { drop_caches(mem); }
+		if ((jit != NULL) && !D && (trace == NULL) && jit->run(*this, mem, end)) { return; } //binary mode only, traces need every instruction
+		CodeBlock& b = blocks[address & (DECODE_SLOTS - 1)];
+		if ((b.generation == 0) || b.pages.remapped(mem, b.generation)) { build_block(mem, address, b); }
+		if ((b.count > 0) && (mem.cycles + b.cycles + b.crossings <= end)) { //even the last instruction starts before end, as one by one
+			for (int i = 0; i < b.count; i++) { run_decoded(mem, decoded[PC & (DECODE_SLOTS - 1)]); } //entries sit on the block's pages, current with it
+			return;
 		}
-		step = step - 1 + PC_cross_PB;
-		break;
+	}
+	execute(mem);
+}
+
+// ####### shared behaviour #####
+
+void Processor::push(MemIO& mem, unsigned char value) {
+	mem.write(0x100 | SP, value); //stack page, lands in RIOT RAM through the $180 mirror
+	SP = SP - 1; //decrementing SP after push
+}
+
+unsigned char Processor::pull(MemIO& mem) {
+	SP = SP + 1; //adjusting stack top to reflect pop operation (and points to topmost element)
+	return mem.read(0x100 | SP);
+}
+
+void Processor::set_NZ(unsigned char value) { //two stores, the compares happen in the rare instruction that reads N or Z
+	N_result = value;
+	Z_result = value;
+}
+
+unsigned char Processor::SR() const {
+	return pack_SR(N(), V, B_h, B_l, D, I, Z(), C);
+}
+
+void Processor::do_compare(unsigned char reg, unsigned char value) {
+	C = (reg >= value); //setting carry if register value is greater than or equal to memory contents
+	set_NZ(reg - value);
+}
 
-	/* ####### Branch on result Plus (BPL) #########*/
+// Decimal mode follows the NMOS 6502: the result is BCD corrected, Z comes from the binary sum, N and V from the sum
+// after the low digit is corrected (ADC) or from the binary difference (SBC), C from the corrected digits. Every case
+// is worked out at compile time so a decimal ADC or SBC is one table load. Operands that are not valid BCD give the
+// same bytes and flags as the real chip.
+struct DecimalEntry {
+	unsigned char result;
+	unsigned char flags; //N, V, Z and C where pack_SR puts them
+};
+
+constexpr DecimalEntry decimal_add(int a, int m, int c) {
+	int binary = a + m + c;
+	int low = (a & 0x0F) + (m & 0x0F) + c;
+	int sum = (low > 0x09) ? ((low + 0x06) & 0x0F) + (a & 0xF0) + (m & 0xF0) + 0x10 : low + (a & 0xF0) + (m & 0xF0);
+	int flags = (sum & 0x80) | ((((a ^ sum) & 0x80) && !((a ^ m) & 0x80)) ? 0x40 : 0) | (((binary & 0xFF) == 0) ? 0x02 : 0);
+	if ((sum & 0x1F0) > 0x90) { sum = sum + 0x60; } //high digit correction, after N and V were taken
+	if ((sum & 0xFF0) > 0xF0) { flags = flags | 0x01; }
+	return DecimalEntry{ (unsigned char)sum, (unsigned char)flags };
+}
+
+constexpr DecimalEntry decimal_subtract(int a, int m, int c) {
+	int binary = a - m - (1 - c); //flags are all binary on the NMOS part
+	int low = (a & 0x0F) - (m & 0x0F) - (1 - c);
+	int difference = (low & 0x10) ? ((low - 0x06) & 0x0F) | ((a & 0xF0) - (m & 0xF0) - 0x10) : (low & 0x0F) | ((a & 0xF0) - (m & 0xF0));
+	if (difference & 0x100) { difference = difference - 0x60; } //high digit borrowed
+	int flags = (binary & 0x80) | ((((a ^ binary) & 0x80) && ((a ^ m) & 0x80)) ? 0x40 : 0) | (((binary & 0xFF) == 0) ? 0x02 : 0) | ((binary >= 0) ? 0x01 : 0);
+	return DecimalEntry{ (unsigned char)difference, (unsigned char)flags };
+}
 
-	case 0x10: // BPL res, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1);
-		if (N == 0) {// result is positive
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			PC = PC + offset + 2;
+struct DecimalTable { //indexed by carry in, A and the operand
+	DecimalEntry entry[2][256][256];
+	constexpr DecimalTable(bool subtract) : entry() {
+		for (int c = 0; c < 2; c++) {
+			for (int a = 0; a < 256; a++) {
+				for (int m = 0; m < 256; m++) { entry[c][a][m] = subtract ? decimal_subtract(a, m, c) : decimal_add(a, m, c); }
+			}
 		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
+	}
+};
+
+static constexpr DecimalTable decimal_adc(0);
+static constexpr DecimalTable decimal_sbc(1);
+
+void Processor::decimal_result(unsigned char result, unsigned char flags) {
+	A = result;
+	C = flags & 0x01;
+	V = flags & 0x40;
+	Z_result = ~flags & 0x02;
+	N_result = flags;
+}
+
+template<> void Processor::alu<AluOp::ADC>(unsigned char value) {
+	if (D) {
+		const DecimalEntry& e = decimal_adc.entry[C][A][value];
+		decimal_result(e.result, e.flags);
+		return;
+	}
+	unsigned int Ap = A + value + C; // doing operation without risk of overflow
+	unsigned char res = Ap; //casting to word size
+	V = (~(A ^ value) & (A ^ res) & 0x80); //signed overflow: both operands share a sign that the result does not have
+	C = (Ap > 0xFF);
+	A = res;
+	set_NZ(A);
+}
+
+template<> void Processor::alu<AluOp::SBC>(unsigned char value) {
+	if (D) {
+		const DecimalEntry& e = decimal_sbc.entry[C][A][value];
+		decimal_result(e.result, e.flags);
+		return;
+	}
+	alu<AluOp::ADC>(~value); //A - M - !C is A + ~M + C in two's complement
+}
+
+template<> void Processor::alu<AluOp::AND>(unsigned char value) { A = A & value; set_NZ(A); }
+template<> void Processor::alu<AluOp::EOR>(unsigned char value) { A = A ^ value; set_NZ(A); }
+template<> void Processor::alu<AluOp::ORA>(unsigned char value) { A = A | value; set_NZ(A); }
+template<> void Processor::alu<AluOp::LDA>(unsigned char value) { A = value; set_NZ(A); }
+template<> void Processor::alu<AluOp::CMP>(unsigned char value) { do_compare(A, value); }
+
+template<> unsigned char Processor::rmw<RmwOp::ASL>(unsigned char value) {
+	C = value & 0x80; // keeping the last bit for the carry flag (hint: 0x80 is binary 1000 0000)
+	value = value << 1;
+	set_NZ(value);
+	return value;
+}
+
+template<> unsigned char Processor::rmw<RmwOp::LSR>(unsigned char value) {
+	C = value & 0x01; //keeping LSB
+	value = value >> 1;
+	set_NZ(value);
+	return value;
+}
+
+template<> unsigned char Processor::rmw<RmwOp::ROL>(unsigned char value) {
+	bool Cp = value & 0x80; //MSB becomes the new carry
+	value = (value << 1) | C; //shifting left and inserting old carry
+	C = Cp;
+	set_NZ(value);
+	return value;
+}
+
+template<> unsigned char Processor::rmw<RmwOp::ROR>(unsigned char value) {
+	bool Cp = value & 0x01; //LSB becomes the new carry
+	value = (value >> 1) | (C << 7); //old carry is shoved into MSB position
+	C = Cp;
+	set_NZ(value);
+	return value;
+}
+
+template<> unsigned char Processor::rmw<RmwOp::INC>(unsigned char value) {
+	value = value + 1;
+	set_NZ(value);
+	return value;
+}
+
+template<> unsigned char Processor::rmw<RmwOp::DEC>(unsigned char value) {
+	value = value - 1;
+	set_NZ(value);
+	return value;
+}
+
+void Processor::branch(MemIO& mem, bool condition) {
+	signed char offset = (signed char)operand; // an 8bit signed offset, relative to the next instruction, plain char is unsigned on ARM
+	if (condition) {
+		extra_cycles = 1 + crossing_page_jump(PC, offset); //taken branch costs one cycle, two if target is on another page
+		PC = PC + offset;
+		if ((offset < 0) && idle_skip) { skip_idle_loop(mem, PC - offset - 2); } //loop closed, maybe a polling loop
+	}
+}
+
+// ####### idle loop skipping #####
+// A loop that writes nothing and only reads memory that cannot change while it spins (RAM, ROM, ports, TIA inputs) or
+// changes at known times (the RIOT timer) is a pure function of the registers. Once two passes in a row end with the
+// same registers, every following pass does too until the timer next ticks, so those passes are skipped by moving the
+// clock. The TIA catches up on its next access since it renders lazily.
+
+static int idle_class(const char* mnemonic) { //0: may write or jump, 1: registers and flags only, 2: reads its operand
+	static const char* reads[] = { "ADC", "AND", "BIT", "CMP", "CPX", "CPY", "EOR", "LDA", "LDX", "LDY", "ORA", "SBC" };
+	static const char* registers[] = { "ASL", "LSR", "ROL", "ROR", "CLC", "CLD", "CLI", "CLV", "SEC", "SED", "SEI", "NOP",
+		"DEX", "DEY", "INX", "INY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA" }; //shifts only qualify on A
+	for (unsigned int i = 0; i < sizeof(reads) / sizeof(reads[0]); i++) {
+		if (strcmp(mnemonic, reads[i]) == 0) { return 2; }
+	}
+	for (unsigned int i = 0; i < sizeof(registers) / sizeof(registers[0]); i++) {
+		if (strcmp(mnemonic, registers[i]) == 0) { return 1; }
+	}
+	return 0;
+}
+
+void Processor::analyse_loop(MemIO& mem, IdleLoop& loop) {
+	loop.idle = 0;
+	loop.reads_timer = 0;
+	loop.body_cycles = 0;
+	loop.pages.count = 0;
+	if ((loop.branch_pc - loop.head) > IDLE_MAX_BODY) { return; }
+	unsigned short pc = loop.head;
+	while (pc != loop.branch_pc) { //straight-line body: the closing branch is the only way in or out
+		if (mem.page_device[(pc & MemIO::ADDRESS_MASK) >> MemIO::PAGE_BITS] != MemIO::DEV_ROM) { return; } //only ROM code is known not to change
+		const OpInfo& op = op_table[mem.read(pc)];
+		int kind = idle_class(op.mnemonic);
+		if (kind == 0) { return; }
+		if (!loop.pages.add(pc & MemIO::ADDRESS_MASK, op.bytes)) { return; }
+		if ((op.mode == AddrMode::ZP) || (op.mode == AddrMode::ABS)) { //fixed address, check what it reads
+			if (kind != 2) { return; } //shift on memory, writes back
+			unsigned short address = mem.read(pc + 1);
+			if (op.mode == AddrMode::ABS) { address = concatenate2x8b(mem.read(pc + 1), mem.read(pc + 2)); }
+			address = address & MemIO::ADDRESS_MASK;
+			if (!loop.pages.add(address, 1)) { return; }
+			MemIO::Device device = mem.page_device[address >> MemIO::PAGE_BITS];
+			if (device == MemIO::DEV_CART) { return; } //hotspots and cartridge registers react to reads
+			if (device == MemIO::DEV_TIA) {
+				if ((address & 0x0F) < 0x08) { return; } //collision latches change as the beam draws
+			}
+			else if (device == MemIO::DEV_RIOT_IO) {
+				if (address & 0x04) { loop.reads_timer = 1; }
+			}
 		}
-		step = step - 1 + PC_cross_PB;
-		break;
-	/* ######## Force Break (BRK) #######*/
-	
-	case 0x00: // BRK, 1b 7c 
-		step = 7;
-		//keeping record of current SR and PC before stack push
-		SR_backup = pack_SR(N, V, B_h, B_l, D, I, Z, C);
-		PC_backup = PC + 2;
-		low = PC_backup; //short to char cast gets rid of upper byte
-		high = (PC_backup >> 8); //keep topmost byte
-		//setting flags
-		I = 1;	
-		B_l = 1;
-		//pushing PC+2 to stack
-		mem.write(SP, high); // stored first byte
-		SP = SP - 1; //decrementing stack
-		mem.write(SP, low); //stored upper byte
-		SP = SP - 1; //updating stack pointer to reflect new stack "top"
-		//pushing SR to stack
-		mem.write(SP, SR_backup);
-		SP = SP - 1; //pushed SR to stack
-		//fetching new PC, stored at addresses $FFFE and $FFFF
-		low = mem.read(0xFFFE);
-		high = mem.read(0xFFFF);
-		PC = concatenate2x8b(low, high); //new PC to run from
-
-	/* ###### Branch on Overflow Clear (BVC) #######*/
-
-	case 0x50: // BVC relative, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1); //getting offset from instruction
-		if (V == 0) { //if overcflow clear
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			PC = PC + offset + 2;
+		else if ((op.mode != AddrMode::IMP) && (op.mode != AddrMode::ACC) && (op.mode != AddrMode::IMM)) { return; } //indexed and indirect reads are not followed
+		loop.body_cycles = loop.body_cycles + op.cycles;
+		pc = pc + op.bytes;
+		if ((unsigned short)(pc - loop.head) > IDLE_MAX_BODY) { return; } //ran past the branch, it sits inside an instruction
+	}
+	if (!loop.pages.add(pc & MemIO::ADDRESS_MASK, 2)) { return; }
+	loop.body_cycles = loop.body_cycles + op_table[mem.read(pc)].cycles;
+	loop.idle = 1;
+}
+
+void Processor::skip_idle_loop(MemIO& mem, unsigned short branch_pc) {
+	IdleLoop& loop = idle_loops[branch_pc & (IDLE_SLOTS - 1)];
+	if ((loop.branch_pc != branch_pc) || (loop.head != PC) || loop.pages.remapped(mem, loop.generation)) { //new loop in this slot
+		loop.branch_pc = branch_pc;
+		loop.head = PC;
+		loop.generation = mem.map_generation;
+		loop.armed = 0;
+		analyse_loop(mem, loop);
+	}
+	if (!loop.idle) { return; }
+	unsigned long long now = mem.cycles + extra_cycles; //clock once this branch completes
+	int period = loop.body_cycles + extra_cycles; //one full pass, branch included
+	unsigned char status = SR(); //lazy N and Z compare as flags, not as the bytes behind them
+	bool repeat = loop.armed && (now - loop.last_cycle == (unsigned long long)period) && (A == loop.A) && (X == loop.X) && (Y == loop.Y) && (SP == loop.SP) && (status == loop.SR);
+	if (repeat) { //fixed point, passes are identical until something the loop reads changes
+		unsigned long long horizon = skip_limit;
+		if (loop.reads_timer) {
+			unsigned long long tick = mem.riot.next_change(now - period); //from the start of this pass, a tick after its reads but before the branch went unseen
+			if (tick < horizon) { horizon = tick; }
 		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
+		if (horizon > now + MemIO::MAX_FRAME_CYCLES) { horizon = now + MemIO::MAX_FRAME_CYCLES; } //bounded jump when nothing limits it
+		if (horizon > now) {
+			unsigned long long passes = (horizon - now) / period;
+			if (passes > 1) { //the last pass before the horizon is run for real, its reads may land on the change
+				passes = passes - 1;
+				extra_cycles = extra_cycles + (int)(passes * period);
+				now = now + passes * period;
+			}
 		}
-		step = step - 1 + PC_cross_PB;
-		break;
+	}
+	loop.armed = 1;
+	loop.last_cycle = now;
+	loop.A = A;
+	loop.X = X;
+	loop.Y = Y;
+	loop.SP = SP;
+	loop.SR = status;
+}
 
-		/* ###### Branch on Overflow set (BVS) #######*/
+void Processor::unpack_SR(unsigned char SR) {
+	C = SR & 0x01; //bit 0
+	Z_result = ~SR & 0x02; //bit 1
+	I = SR & 0x04; //bit 2
+	D = SR & 0x08; //bit 3
+	B_l = SR & 0x10; //bit 4
+	B_h = SR & 0x20; //bit 5
+	V = SR & 0x40; //bit 6
+	N_result = SR; //bit 7
+}
 
-	case 0x70: // BVS relative, 2b 2c++
-		step = 2;
-		offset = mem.read(PC + 1); //getting offset from instruction
-		if (V == 1) { //if overcflow set
-			PC_cross_PB = crossing_page_jump(PC, offset);
-			PC = PC + offset + 2;
-		}
-		else {
-			PC = PC + 2;
-			PC_cross_PB = 0;
-		}
-		step = step - 1 + PC_cross_PB;
-		break;
-	
-	/* ########### Clear Carry Flag (CLC) ########*/
-
-	case 0x18: // CLC 1b 2c
-		step = 2;
-		C = 0; //clearing flag
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	/* ########### Clear decimal Flag (CLD) ########*/
-
-	case 0xD8: // CLD 1b 2c
-		step = 2;
-		D = 0; //clearing flag
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	/* ########### Clear interrupt disable bit (CLI) ########*/
-
-	case 0x58: // CLI 1b 2c
-		step = 2;
-		I = 0; //clearing flag
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-		/* ########### Clear overflow Flag (CLV) ########*/
-
-	case 0xB8: // CLV 1b 2c
-		step = 2;
-		V = 0; //clearing flag
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	/* ###### Compare Memory with Accumulator (CMP) ######*/
-
-	case 0xC9: // CMP immediate, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1);
-		C = (A >= imm); //setting carry if A value is gretaer than memory contents
-		imm = A - imm; //result of accumulator/memory compare
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xC5: // CMP zeropage 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp); //value to compare 
-		C = (A >= imm);
-		imm = A - imm; //doing the operation
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xD5: //  CMP zeropage X, 2b 4c
-		step = 4;
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp); //value to compare 
-		C = (A >= imm);
-		imm = A - imm; //doing the operation
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xCD: //CMP absolute 3b 4c
-		step = 3;
-		//fetching address
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high);
-		//fetching data
-		imm = mem.read(val_ptr);
-		C = (A >= imm); 
-		imm = A - imm;
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0xDD: //CMP absolute X 3b 4c+
-		step = 4;
-		//fetching address
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X;
-		//fetching data
-		imm = mem.read(val_ptr);
-		C = (A >= imm);
-		imm = A - imm;
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-	
-	case 0xD9: //CMP absolute Y 3b 4c+
-		step = 4;
-		//fetching address
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + Y;
-		//fetching data
-		imm = mem.read(val_ptr);
-		C = (A >= imm);
-		imm = A - imm;
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	case 0xC1: //CMP pre-indexed X, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X;
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		C = (A >= imm); //setting flag
-		imm = A - imm; // getting compare
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xD1: // CMP post-indexed Y, 2b 5c+
-		step = 5;
-		add_ptr_zp = mem.read(PC + 1); //zeropage address of pointer 
-		low = mem.read(add_ptr_zp); // low byte of pointer address
-		high = mem.read(add_ptr_zp + 1); //high """"
-		val_ptr = concatenate2x8b(low, high) + Y; // real address of value zith added index
-		//instruction body
-		imm = mem.read(val_ptr);
-		C = (A >= imm); //setting flag
-		imm = A - imm; // getting compare
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	/* ################# Compare Memory and Index X (CPX) #######*/
-
-	case 0xE0: //CPX imm, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1);
-		C = (X >= imm); //setting carry if A value is greater than memory contents
-		imm = X - imm; //result of accumulator/memory compare
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xE4: //CPX zp, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp); //value to compare 
-		C = (X >= imm);
-		imm = X - imm; //doing the operation
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xEC: // CPX abs, 3b 4c
-		step = 3;
-		//fetching address
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high);
-		//fetching data
-		imm = mem.read(val_ptr);
-		C = (X >= imm);
-		imm = X - imm;
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 3;
-		step = step - 1;
-		break;
-		/* ########## Compare Memory with index Y (CPY) ########*/
-	case 0xC0: //CPY imm, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1);
-		C = (Y >= imm); //setting carry if A value is greater than memory contents
-		imm = Y - imm; //result of accumulator/memory compare
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xC4: //CPY zp, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp); //value to compare 
-		C = (Y >= imm);
-		imm = Y - imm; //doing the operation
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xCC: // CPX abs, 3b 4c
-		step = 3;
-		//fetching address
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high);
-		//fetching data
-		imm = mem.read(val_ptr);
-		C = (Y >= imm);
-		imm = Y - imm;
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	/* ######## Decrement memory by one (DEC) #######*/
-
-	case 0xC6: // DEC zeropage, 2b 5c
-		step = 5;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp) - 1; // getting value from memory and decrementing
-		//writing back to memory
-		mem.write(val_ptr_zp, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xD6: // DEC zeropage X, 2b 6c
-		step = 6;
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp) - 1; // getting value from memory and decrementing
-		//writing back to memory
-		mem.write(val_ptr_zp, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xCE: // DEC absolute, 3b 6c
-		step = 6;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr) -1;// getting value and decrementing by 1
-		//writing back
-		mem.write(val_ptr, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0xDE: // DEC absolute X, 3b 7c
-		step = 7;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X;
-		imm = mem.read(val_ptr) - 1;// getting value and decrementing by 1
-		//writing back
-		mem.write(val_ptr, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-	
-	/* ######### Decrement index X by one (DEX) ######*/
-
-	case 0xCA: // DEX 1b 2c
-		step = 2;
-		X = X - 1; //decrementing X
-		N = isNegative_8b(X);
-		Z = (X == 0);
-		//done
-		step = step - 1;
-		PC = PC + 1;
-		break;
-
-	/* ######### Decrement index Y by one (DEY) ######*/
-
-	case 0x88: // DEY 1b 2c
-		step = 2;
-		Y = Y - 1; //decrementing Y
-		N = isNegative_8b(Y);
-		Z = (Y == 0);
-		//done
-		step = step - 1;
-		PC = PC + 1;
-		break;
-
-	/* ######### Exclusive OR with accumulator (EOR)########*/
-
-	case 0x49: //EOR immediate, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1);
-		A = A ^ imm; //bitwise XOR
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x45: // EOR zeropage, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1); //address of operand in ZP
-		imm = mem.read(val_ptr_zp);
-		A = A ^ imm; //bitwise XOR
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x55: //EOR Zeropage X, 2b 4c
-		step = 4;
-		val_ptr_zp = mem.read(PC + 1) + X; //address of operand in ZP
-		imm = mem.read(val_ptr_zp);
-		A = A ^ imm; //bitwise XOR
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x4D: // EOR abs, 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); //address of operand
-		imm = mem.read(val_ptr);
-		A = A ^ imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x5D: // EOR abs X, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; //address of operand
-		imm = mem.read(val_ptr);
-		A = A ^ imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-
-	case 0x59: // EOR abs Y, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + Y; //address of operand
-		imm = mem.read(val_ptr);
-		A = A ^ imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	case 0x41: // EOR pre-indirect X, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X;
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		A = A ^ imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x51: //EOR post-indirect Y, 2b 5c+
-		step = 5;
-		add_ptr_zp = mem.read(PC + 1);
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high) + Y;
-		imm = mem.read(val_ptr);
-		A = A ^ imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	/* ######### Increment memory by one (INC) ######*/
-
-	case 0xE6: // INC Zeropage, 2b 5c
-		step = 5;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp) + 1; //incremented value from ram
-		//writing back to ram!
-		mem.write(val_ptr_zp, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done 
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xF6: // INC zeropage X, 2b 6c
-		step = 6;
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp) + 1; //incremented value from ram
-		//writing back to ram!
-		mem.write(val_ptr_zp, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done 
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xEE: // INC absolute, 3b 6c
-		step = 6;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); //pointer to operand
-		imm = mem.read(val_ptr) + 1; // incrementing memory value by 1
-		//writing back !
-		mem.write(val_ptr, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		step = step - 1;
-		PC = PC + 3;
-		break;
-
-	case 0xFE: // INC absolute X, 3b 7c
-		step = 7;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; //pointer to operand
-		imm = mem.read(val_ptr) + 1; // incrementing memory value by 1
-		//writing back !
-		mem.write(val_ptr, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		step = step - 1;
-		PC = PC + 3;
-		break;
-
-	/* ###### Increment X by one (INX) #####*/
-
-	case 0xE8: //INX implied, 1b 2c
-		step = 2;
-		X = X + 1;
-		//setting flags
-		N = isNegative_8b(X);
-		Z = (X == 0);
-		//done
-		step = step - 1;
-		PC = PC + 1;
-		break;
-
-	/* ###### Increment Y by one (INY) #####*/
-
-	case 0xC8: //INY implied, 1b 2c
-		step = 2;
-		Y = Y + 1;
-		//setting flags
-		N = isNegative_8b(Y);
-		Z = (Y == 0);
-		//done
-		step = step - 1;
-		PC = PC + 1;
-		break;
-
-	/* ################### Jump to new location (JMP) #######*/
-
-	case 0x4C: // JMP absolute, 3b 3c
-		step = 3;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high); //new target
-		PC = add_ptr; // jumping
-		step = step - 1;
-		break;
-
-	case 0x6C: // JMP indirect, 3b 5c
-		step = 5;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high); // address of jump pointer target
-		low = mem.read(add_ptr);
-		high = mem.read(add_ptr + 1);
-		add_ptr = concatenate2x8b(low, high); // address to jump to
-		PC = add_ptr; //jump
-		step = step - 1;
-		break;
-
-/* ################ Jump to new location, saving return address (JSR) ###############*/
-	
-	case 0x20: //JSR absolute, 3b 6c
-		step = 6;
-		PC_backup = PC + 2; //current PC
-		low = PC_backup; //casting to char eliminates high byte
-		high = (PC_backup >> 8); // short to char cast only retains the high byte after shift
-		//saving to stack
-		mem.write(SP, high);
-		SP = SP - 1; //updating stack
-		mem.write(SP, low);
-		SP = SP - 1; //fully written to stack
-		//fetching instruction to jump to
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high);// new target
-		PC = add_ptr; //jumping to PC
-		step = step - 1;
-		break;
-
-/* ############### Load accumulator with memory (LDA) #############*/
-
-	case 0xA9: // LDA imm, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1); // memory
-		A = imm; //saving to accumulator 
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xA5: // LDA zp, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1); // zp address of memory value
-		imm = mem.read(val_ptr_zp);
-		A = imm; //saving to accumulator
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xB5: // LDA zp X, 2b 4c
-		step = 4;
-		val_ptr_zp = mem.read(PC + 1) + X; // zp address of memory value
-		imm = mem.read(val_ptr_zp);
-		A = imm; //saving to accumulator
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xAD: //LDA abs, 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); // pointer to operand
-		imm = mem.read(val_ptr);
-		A = imm; //saving to A
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0xBD: //LDA abs X, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; // pointer to operand
-		imm = mem.read(val_ptr);
-		A = imm; //saving to A
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-	
-	case 0xB9: //LDA abs Y, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + Y; // pointer to operand
-		imm = mem.read(val_ptr);
-		A = imm; //saving to A
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	case 0xA1:  // LDA pre indexed X, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X;
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high); //pointer to operand
-		imm = mem.read(val_ptr);
-		A = imm; //setting A 
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xB1: // LDA post-indexed Y, 2b 5c+
-		step = 5;
-		add_ptr_zp = mem.read(PC + 1);
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high) + Y;
-		imm = mem.read(val_ptr);
-		A = imm; //setting accumulator
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	/* ####### Load index X with memory (LDX) #####*/
-
-	case 0xA2: // LDX imm, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1); // memory
-		X = imm; //saving to X 
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xA6: // LDX zp, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1); // zp address of memory value
-		imm = mem.read(val_ptr_zp);
-		X = imm; //saving to X
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xB6: // LDX zp Y, 2b 34
-		step = 4;
-		val_ptr_zp = mem.read(PC + 1) + Y; // zp address of memory value
-		imm = mem.read(val_ptr_zp);
-		X= imm; //saving to X
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xAE: //LDX abs, 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); // pointer to operand
-		imm = mem.read(val_ptr);
-		X = imm; //saving to X
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0xBE: //LDX abs Y, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + Y; // pointer to operand
-		imm = mem.read(val_ptr);
-		X = imm; //saving to X
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	/* ##### Load index Y with memory (LDY) ######*/
-
-	case 0xA0: // LDY imm, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1); // memory
-		Y = imm; //saving to Y
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xA4: // LDY zp, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1); // zp address of memory value
-		imm = mem.read(val_ptr_zp);
-		Y = imm; //saving to Y
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xB4: // LDY zp X, 2b 4c
-		step = 4;
-		val_ptr_zp = mem.read(PC + 1) + X; // zp address of memory value
-		imm = mem.read(val_ptr_zp);
-		Y = imm; //saving to Y
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xAC: //LDY abs, 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); // pointer to operand
-		imm = mem.read(val_ptr);
-		Y = imm; //saving to Y
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0xBC: //LDY abs X, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; // pointer to operand
-		imm = mem.read(val_ptr);
-		Y = imm; //saving to Y
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-
-	/* ###### Shift one bit right memory or accumulator (LSR) #####*/
-
-	case 0x4A: // LSR acc, 1b 2c
-		step = 2;
-		C = (A & 1); //keeping LSB
-		A = A >> 1; // right shift
-		//setting flags 
-		N = 0;
-		Z = (A == 0);
-		//done
-		step = step - 1;
-		PC = PC + 1;
-		break;
-
-	case 0x46: // LSR zp, 2b 5c;
-		step = 5;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp);
-		C = (imm & 1); //getting lsb
-		imm = imm >> 1; //shifting
-		mem.write(val_ptr_zp, imm); //writing back!
-		//setting flags 
-		N = 0;
-		Z = (imm == 0);
-		//done
-		step = step - 1;
-		PC = PC + 2;
-		break;
-
-	case 0x56: // LSR zp x, 2b 5c;
-		step = 5;
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp);
-		C = (imm & 1); //getting lsb
-		imm = imm >> 1; //shifting
-		mem.write(val_ptr_zp, imm); //writing back!
-		//setting flags 
-		N = 0;
-		Z = (imm == 0);
-		//done
-		step = step - 1;
-		PC = PC + 2;
-		break;
-
-	case 0x4E: // LSR absolute, 3b 6c
-		step = 5;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); //address of memory element
-		imm = mem.read(val_ptr);
-		C = (imm & 1);
-		imm = imm >> 1; //shift
-		mem.write(val_ptr, imm); //writeback
-		//setting flags 
-		N = 0;
-		Z = (imm == 0);
-		//done
-		step = step - 1;
-		PC = PC + 3;
-		break;
-
-	case 0x5E: // LSR absolute X, 3b 6c
-		step = 5;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; //address of memory element
-		imm = mem.read(val_ptr);
-		C = (imm & 1);
-		imm = imm >> 1; //shift
-		mem.write(val_ptr, imm); //writeback
-		//setting flags 
-		N = 0;
-		Z = (imm == 0);
-		//done
-		step = step - 1;
-		PC = PC + 3;
-		break;
-
-	/* #### No operation (NOP) #####*/
-
-	case 0xEA: // NOP, 1b 2c
-		step = 2;
-		//nothing happens !
-		PC = PC + 1; 
-		step = step - 1;
-		break;
-
-	/* OR memory with accumulator (ORA) ####*/
-
-	case 0x09: //ORA immediate, 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1);
-		A = A | imm; //bitwise OR
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x05: // ORA zeropage, 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1); //address of operand in ZP
-		imm = mem.read(val_ptr_zp);
-		A = A | imm; //bitwise OR
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x15: //ORA Zeropage X, 2b 4c
-		step = 4;
-		val_ptr_zp = mem.read(PC + 1) + X; //address of operand in ZP
-		imm = mem.read(val_ptr_zp);
-		A = A | imm; //bitwise OR
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x0D: // ORA abs, 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); //address of operand
-		imm = mem.read(val_ptr);
-		A = A | imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x1D: // ORA abs X, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; //address of operand
-		imm = mem.read(val_ptr);
-		A = A | imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-
-	case 0x19: // ORA abs Y, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + Y; //address of operand
-		imm = mem.read(val_ptr);
-		A = A | imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	case 0x01: // ORA pre-indirect X, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X;
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		A = A | imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x11: //ORA post-indirect Y, 2b 5c+
-		step = 5;
-		add_ptr_zp = mem.read(PC + 1);
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high) + Y;
-		imm = mem.read(val_ptr);
-		A = A | imm;
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		PC = PC + 2;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-
-/* ###### Push accumulator on stack (PHA) ####*/
-
-	case 0x48: //PHA implied, 1b3c
-		step = 3;
-		mem.write(SP, A);
-		SP = SP - 1; //decrementing SP after push
-		step = step - 1;
-		PC = PC + 1;
-		break;
-
-	/* ###### Push SR on stack (PHP) ####*/
-	
-	case 0x08: // PHP 1b 3c
-		step = 3;
-		//setting both B flags to 1 as required
-		B_l = 1;
-		B_h = 1;
-		SR_backup = pack_SR(N, V, B_h, B_l, D, I, Z, C);
-		//pushing to stack
-		mem.write(SP, SR_backup);
-		SP = SP - 1; 
-		//done
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-/* ###### Pull A from stack (PLA) ####*/
-
-	case 0x68: //PLA 1b 4c
-		step = 4;
-		//popping stack
-		SP = SP + 1; //adjusting stack top to reflect pop operation (and points to topmost element)
-		imm = mem.read(SP);
-		A = imm; //loading into A
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		step = step - 1;
-		PC = PC + 1;
-		break;
-
-/* ### PULL processor status from stack (PLP) #####*/
-	
-	case 0x28: // PLP 1b 4c
-		step = 4;
-		//popping stack 
-		SP = SP + 1;
-		imm = mem.read(SP);
-		//setting flags
-		C = (imm & 1); //bit 0
-		Z = (imm & 0x02); //bit 1;
-		I = (imm & 0x04); //bit 2
-		D = (imm & 0x08); //bit 3
-		B_l = (imm & 0x10); //bit 4
-		B_h = (imm & 0x20); //bit 5
-		V = (imm & 0x40); //bit 6
-		N = (imm & 0x80); //bit 7
-		//done getting flags
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	/* ####### Rotate one bit left (ROL) ######*/
-
-	case 0x2A: //ROL acc, 1b 2c
-		step = 2;
-		C = (A & 0x80); //saving MSB of A
-		imm = (A << 1) | C; // bit shifting to the left, and inserting carry
-		A = imm; //saving to acc
-		//setting flags
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0x26: //ROL ZP, 2b 5c
-		step = 5;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp); //value to rotate
-		C = (imm & 0x80);//MSB
-		imm = (imm << 1) | C;
-		//writing back
-		mem.write(val_ptr_zp, imm);
-		//setting flags;
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x36: // ROL ZP X, 2b 6c
-		step = 6;
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp); //value to rotate
-		C = (imm & 0x80);//MSB
-		imm = (imm << 1) | C;
-		//writing back
-		mem.write(val_ptr_zp, imm);
-		//setting flags;
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x2E: //ROL absolute, 3b 6c
-		step = 6;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); //address of immediate
-		imm = mem.read(val_ptr);
-		C = (imm & 0x80);
-		imm = (imm << 1) | C; //shifting left and inserting carry
-		//writing back
-		mem.write(val_ptr, imm);
-		//setting flags;
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x3E: //ROL absolute X, 3b 7c
-		step = 7;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; //address of immediate
-		imm = mem.read(val_ptr);
-		C = (imm & 0x80);
-		imm = (imm << 1) | C; //shifting left and inserting carry
-		//writing back
-		mem.write(val_ptr, imm);
-		//setting flags;
-		Z = (imm == 0);
-		N = isNegative_8b(imm);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	/* ##########  Rotate one bit right (ROR)  #######*/
-
-	case 0x6A: // ROR A, 1b 2c
-		step = 2;
-		C = A & 0x01; //fetching LSB to insert later
-		A = (A >> 1) | (C << 7); //carry bit is shoved to MSB position, and inserted into MSB of A. computation done!
-		//setting flags
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		//done
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0x66: // ROR ZP, 2b 5c
-		step = 5;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp);
-		C = imm & 0x01; //getting LSB to insert
-		imm = (imm >> 1) | (C << 7); 
-		//writing back
-		mem.write(val_ptr_zp, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x76: // ROR ZP x, 2b 6c
-		step = 6;
-		val_ptr_zp = mem.read(PC + 1) + X; //pointer to operand
-		imm = mem.read(val_ptr_zp);
-		C = imm & 0x01; //getting LSB to insert
-		imm = (imm >> 1) | (C << 7);
-		//writing back
-		mem.write(val_ptr_zp, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x6E: // ROR absolute, 3b 6c
-		step = 6;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high); //pointer to imm
-		imm = mem.read(val_ptr);
-		C = imm & 0x01; //lsb to insert into msb position later
-		imm = (imm >> 1) | (C << 7);
-		//writing back
-		mem.write(val_ptr, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x7E: // ROR absolute x, 3b 7c
-		step = 7;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X; //pointer to imm
-		imm = mem.read(val_ptr);
-		C = imm & 0x01; //lsb to insert into msb position later
-		imm = (imm >> 1) | (C << 7);
-		//writing back
-		mem.write(val_ptr, imm);
-		//setting flags
-		N = isNegative_8b(imm);
-		Z = (imm == 0);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-
-	/* ####### Return from interrupt (RTI) ####*/
-
-	case 0x40: // RTI 1b 6c
-		 step = 6; 
-		 SP = SP + 1; // popping stack
-		 SR_backup = mem.read(SP); //reading topmost element (SR)
-		 //popping PC
-		 SP = SP + 1; 
-		 low = mem.read(SP); //low byte of PC (LE!)
-		 SP = SP + 1;
-		 high = mem.read(SP); //high byte of PC (LE!)
-		 PC_backup = concatenate2x8b(low, high); // full address after ISR, to jump to
-		 // resetting flags from before ISR
-		 C = SR_backup & 0x01;
-		 Z = SR_backup & 0x02;
-		 I = SR_backup & 0x04;
-		 D = SR_backup & 0x08;
-		 B_l = SR_backup & 0x10;
-		 B_h = SR_backup & 0x20;
-		 V = SR_backup & 0x40;
-		 N = SR_backup & 0x80;
-		 // flags reset, now jumping to correct PC!
-		 PC = PC_backup;
-		 step = step - 1;
-		 break;
-
-/* ####### Return from subroutine (RTS) #####*/
-
-	case 0x60: // RTS 1b 6c
-		step = 6;
-		//stack ops
-		SP = SP + 1;
-		low = mem.read(SP);
-		SP = SP + 1;
-		high = mem.read(SP);
-		PC_backup = concatenate2x8b(low, high) + 1; // see JSR instruction. We saved PC + 2 to stack but JSR is 3byte instruction, so this increment is critical so we don't fetch the last byte of JSR instruction
-		PC = PC_backup; //saving, ready to jump next time
-		//done
-		step = step - 1;
-		break;
-
-/* ###### Subtract with borrow (SBC) ###*/
-
-	case 0xE9: // SBC imm 2b 2c
-		step = 2;
-		imm = mem.read(PC + 1);
-		//setting carry flag
-		Cp = (A >= imm);
-		A = A - imm - (~C>> 7); //op on C ensures that if C is initially 0 we are left with 0x01, not 0xFF, given that bool/char addition tends to treat NOT(0) as 255.
-		//setting flags
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xE5: // SBC zp 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1);
-		imm = mem.read(val_ptr_zp);
-		Cp = (A >= imm);
-		A = A - imm - (~C >> 7);
-		//setting flags
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xF5: // SBC zp x 2b 3c
-		step = 3;
-		val_ptr_zp = mem.read(PC + 1) + X;
-		imm = mem.read(val_ptr_zp);
-		Cp = (A >= imm);
-		A = A - imm - (~C >> 7);
-		//setting flags
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xED: // SBC abs, 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		Cp = (A >= imm);
-		A = A - imm - (~C >> 7);
-		//setting flags
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0xFD: // SBC abs x, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + X;
-		imm = mem.read(val_ptr);
-		Cp = (A >= imm);
-		A = A - imm - (~C >> 7);
-		//setting flags
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, X);
-		break;
-
-	case 0xF9: // SBC abs Y, 3b 4c+
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		val_ptr = concatenate2x8b(low, high) + Y;
-		imm = mem.read(val_ptr);
-		Cp = (A >= imm);
-		A = A - imm - (~C >> 7);
-		//setting flags
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 3;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	case 0xE1: // SBC preindirect X, 2b 6c;
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X; //pointer to value pointer
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high);
-		imm = mem.read(val_ptr);
-		Cp = (A >= imm);
-		A = A - imm - (~C >> 7);
-		//setting flags	
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0xF1: // SBC postindirect y, 2b 5c+;
-		step = 5;
-		add_ptr_zp = mem.read(PC + 1); //pointer to value pointer
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		val_ptr = concatenate2x8b(low, high) + Y; // address of imm
-		imm = mem.read(val_ptr);
-		Cp = (A >= imm);
-		A = A - imm - (~C >> 7);
-		//setting flags
-		C = Cp;
-		N = isNegative_8b(A);
-		Z = (A == 0);
-		V = (A > 127); //unsure !
-		//done
-		PC = PC + 2;
-		step = step - 1 + crossing_page_notconcatenated(low, high, Y);
-		break;
-
-	/* #### Set carry flag (SEC)###*/
-
-	case 0x38: // SEC 1b 2c
-		step = 2;
-		C = 1; //setting carry flag
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-/* #### Set decimal flag (SED)###*/
-
-	case 0xF8: // SED 1b 2c
-		step = 2;
-		D = 1; //setting decimal flag
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-
-/* #### interrupt disable flag (SEI)###*/
-
-	case 0x78: // SEI 1b 2c
-		step = 2;
-		I = 1; //setting carry flag
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-
-/* Store accumulator in memory (STA) ####*/
-
-	case 0x85: // STA zp 2b 3c
-		step = 3;
-		add_ptr_zp = mem.read(PC + 1);// address to store A contents
-		//writing back
-		mem.write(add_ptr_zp, A);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x95: // STA ZP X 2b 4c
-		step = 4;
-		add_ptr_zp = mem.read(PC + 1) + X;// address to store A contents
-		//writing back
-		mem.write(add_ptr_zp, A);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x8D: // STA abs; 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high); //address to store A contents
-		//writing back
-		mem.write(add_ptr, A);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x9D: // STA abs x; 3b 5c
-		step = 5;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high) + X; //address to store A contents
-		//writing back
-		mem.write(add_ptr, A);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x99: // STA abs y; 3b 5c
-		step = 5;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high) + Y; //address to store A contents
-		//writing back
-		mem.write(add_ptr, A);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	case 0x81: //STA preindirect x, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1) + X; // pointer to address where A should be stored
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		add_ptr = concatenate2x8b(low, high);// place to store A contents
-		//writing back
-		mem.write(add_ptr, A);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x91: //SDA postindirect t, 2b 6c
-		step = 6;
-		add_ptr_zp = mem.read(PC + 1); // pointer to address where A should be stored
-		low = mem.read(add_ptr_zp);
-		high = mem.read(add_ptr_zp + 1);
-		add_ptr = concatenate2x8b(low, high) + Y;// place to store A contents
-		//writing back
-		mem.write(add_ptr, A);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-
-
-/*###### Store index X in memory (STX) #####*/
-
-	case 0x86: // STX ZP, 2b 3c
-		step = 3; 
-		add_ptr_zp = mem.read(PC + 1);// address to store x contents
-		//writing back
-		mem.write(add_ptr_zp, X);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x96: // STX ZP Y, 2b 4c
-		step = 4;
-		add_ptr_zp = mem.read(PC + 1) + Y;// address to store X contents
-		//writing back
-		mem.write(add_ptr_zp, X);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x8E: // STX abs; 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high); //address to store X contents
-		//writing back
-		mem.write(add_ptr, X);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-		/*###### Store index Y in memory (STY) #####*/
-
-	case 0x84: // STY ZP, 2b 3c
-		step = 3;
-		add_ptr_zp = mem.read(PC + 1);// address to store y contents
-		//writing back
-		mem.write(add_ptr_zp, Y);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x94: // STY ZP X, 2b 4c
-		step = 4;
-		add_ptr_zp = mem.read(PC + 1) + X; // address to store Y contents
-		//writing back
-		mem.write(add_ptr_zp, Y);
-		//done
-		PC = PC + 2;
-		step = step - 1;
-		break;
-
-	case 0x8C: // STY abs; 3b 4c
-		step = 4;
-		low = mem.read(PC + 1);
-		high = mem.read(PC + 2);
-		add_ptr = concatenate2x8b(low, high); //address to store Y contents
-		//writing back
-		mem.write(add_ptr, Y);
-		//done
-		PC = PC + 3;
-		step = step - 1;
-		break;
-
-	/* #### Register Tansfer instructions (TAX, TAY, TSX, TXA, TXS, TYA) ####*/
-
-	case 0xAA: //TAX, 1b 2c
-		step = 2;
-		X = A; 
-		//setting flags
-		N = isNegative_8b(X);
-		Z = (X == 0);
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0xA8: //TAY, 1b 2c
-		step = 2;
-		Y = A;
-		//setting flags
-		N = isNegative_8b(Y);
-		Z = (Y == 0);
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0xBA: //TSX, 1b 2c
-		step = 2;
-		X = SP;
-		//setting flags
-		N = isNegative_8b(X);
-		Z = (X == 0);
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0x8A: //TXA, 1b 2c
-		step = 2;
-		A = X;
-		//setting flags
-		N = isNegative_8b(X);
-		Z = (X == 0);
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0x9A: //TXS, 1b 2c
-		step = 2;
-		SP = X;
-		//no flags set
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	case 0x98: //TYA, 1b 2c
-		step = 2;
-		A = Y;
-		//setting flags
-		N = isNegative_8b(Y);
-		Z = (Y == 0);
-		PC = PC + 1;
-		step = step - 1;
-		break;
-
-	default: // not recognized opcode
-		//handle invalid opcode error
-		break;
-	
-}
-		
+// ####### instruction handlers #####
+
+/*##### Accumulator with memory (ADC, AND, CMP, EOR, LDA, ORA, SBC) #####*/
+template<AddrMode M, AluOp Op> void Processor::op_alu(MemIO& mem, const OpInfo& op) {
+	alu<Op>(fetch_operand<M>(mem));
+}
+
+/*##### Read-modify-write (ASL, LSR, ROL, ROR, INC, DEC) #####*/
+template<AddrMode M, RmwOp Op> void Processor::op_rmw(MemIO& mem, const OpInfo& op) {
+	unsigned short address = operand_address<M>(mem); //no page crossing penalty, already part of base cycles
+	unsigned char value = rmw<Op>(mem.read(address));
+	mem.write(address, value); //writeback complete !
+}
+
+template<RmwOp Op> void Processor::op_rmw_acc(MemIO& mem, const OpInfo& op) {
+	A = rmw<Op>(A);
+}
+
+/* ########### Branches (BCC, BCS, BEQ, BMI, BNE, BPL, BVC, BVS) #############*/
+void Processor::op_BCC(MemIO& mem, const OpInfo& op) { branch(mem, C == 0); }
+void Processor::op_BCS(MemIO& mem, const OpInfo& op) { branch(mem, C == 1); }
+void Processor::op_BEQ(MemIO& mem, const OpInfo& op) { branch(mem, Z_result == 0); }
+void Processor::op_BMI(MemIO& mem, const OpInfo& op) { branch(mem, N_result & 0x80); }
+void Processor::op_BNE(MemIO& mem, const OpInfo& op) { branch(mem, Z_result != 0); }
+void Processor::op_BPL(MemIO& mem, const OpInfo& op) { branch(mem, !(N_result & 0x80)); }
+void Processor::op_BVC(MemIO& mem, const OpInfo& op) { branch(mem, V == 0); }
+void Processor::op_BVS(MemIO& mem, const OpInfo& op) { branch(mem, V == 1); }
+
+/* ######## Test Bits in Memory with accumulator (BIT) #############*/
+template<AddrMode M> void Processor::op_BIT(MemIO& mem, const OpInfo& op) {
+	unsigned char imm = fetch_operand<M>(mem);
+	N_result = imm; //bits 7 and 6 of memory are copied
+	V = imm & 0x40;
+	Z_result = A & imm;
+}
+
+/* ######## Force Break (BRK) #######*/
+void Processor::op_BRK(MemIO& mem, const OpInfo& op) {
+	unsigned short PC_backup = PC + 1; //BRK skips a padding byte
+	//pushing PC+2 to stack, high byte first
+	push(mem, PC_backup >> 8);
+	push(mem, PC_backup); //short to char cast gets rid of upper byte
+	push(mem, pack_SR(N(), V, 1, 1, D, I, Z(), C)); //pushed copy of SR has the break bits set
+	I = 1;
+	//fetching new PC, stored at addresses $FFFE and $FFFF
+	unsigned char low = mem.read(0xFFFE);
+	unsigned char high = mem.read(0xFFFF);
+	PC = concatenate2x8b(low, high); //new PC to run from
 }
+
+/* ########### Flag instructions (CLC, CLD, CLI, CLV, SEC, SED, SEI) ########*/
+void Processor::op_CLC(MemIO& mem, const OpInfo& op) { C = 0; }
+void Processor::op_CLD(MemIO& mem, const OpInfo& op) { D = 0; }
+void Processor::op_CLI(MemIO& mem, const OpInfo& op) { I = 0; }
+void Processor::op_CLV(MemIO& mem, const OpInfo& op) { V = 0; }
+void Processor::op_SEC(MemIO& mem, const OpInfo& op) { C = 1; }
+void Processor::op_SED(MemIO& mem, const OpInfo& op) { D = 1; }
+void Processor::op_SEI(MemIO& mem, const OpInfo& op) { I = 1; }
+
+/* ###### Compare Memory with index registers (CPX, CPY) ######*/
+template<AddrMode M> void Processor::op_CPX(MemIO& mem, const OpInfo& op) { do_compare(X, fetch_operand<M>(mem)); }
+template<AddrMode M> void Processor::op_CPY(MemIO& mem, const OpInfo& op) { do_compare(Y, fetch_operand<M>(mem)); }
+
+/* ######### Decrement/Increment index registers (DEX, DEY, INX, INY) ######*/
+void Processor::op_DEX(MemIO& mem, const OpInfo& op) { X = X - 1; set_NZ(X); }
+void Processor::op_DEY(MemIO& mem, const OpInfo& op) { Y = Y - 1; set_NZ(Y); }
+void Processor::op_INX(MemIO& mem, const OpInfo& op) { X = X + 1; set_NZ(X); }
+void Processor::op_INY(MemIO& mem, const OpInfo& op) { Y = Y + 1; set_NZ(Y); }
+
+/* ################### Jump to new location (JMP, JSR) #######*/
+template<AddrMode M> void Processor::op_JMP(MemIO& mem, const OpInfo& op) {
+	PC = operand_address<M>(mem);
+}
+
+void Processor::op_JSR(MemIO& mem, const OpInfo& op) { //bus order of the 6502: target low byte, pushes, target high byte (FE carts rely on it), so the operand is read here
+	unsigned char low = mem.read(PC - 2);
+	unsigned short PC_backup = PC - 1; //last byte of the JSR instruction, RTS adds one
+	push(mem, PC_backup >> 8);
+	push(mem, PC_backup);
+	unsigned char high = mem.read(PC - 1);
+	PC = concatenate2x8b(low, high);
+}
+
+/* ############### Load index registers with memory (LDX, LDY) #############*/
+template<AddrMode M> void Processor::op_LDX(MemIO& mem, const OpInfo& op) { X = fetch_operand<M>(mem); set_NZ(X); }
+template<AddrMode M> void Processor::op_LDY(MemIO& mem, const OpInfo& op) { Y = fetch_operand<M>(mem); set_NZ(Y); }
+
+/* #### No operation (NOP) #####*/
+void Processor::op_NOP(MemIO& mem, const OpInfo& op) {
+	//nothing happens !
+}
+
+/* ###### Stack operations (PHA, PHP, PLA, PLP) ####*/
+void Processor::op_PHA(MemIO& mem, const OpInfo& op) {
+	push(mem, A);
+}
+
+void Processor::op_PHP(MemIO& mem, const OpInfo& op) {
+	//setting both B flags to 1 as required
+	B_l = 1;
+	B_h = 1;
+	push(mem, SR());
+}
+
+void Processor::op_PLA(MemIO& mem, const OpInfo& op) {
+	A = pull(mem);
+	set_NZ(A);
+}
+
+void Processor::op_PLP(MemIO& mem, const OpInfo& op) {
+	unpack_SR(pull(mem));
+}
+
+/* ####### Return from interrupt/subroutine (RTI, RTS) ####*/
+void Processor::op_RTI(MemIO& mem, const OpInfo& op) {
+	unpack_SR(pull(mem)); // resetting flags from before ISR
+	unsigned char low = pull(mem); //low byte of PC (LE!)
+	unsigned char high = pull(mem);
+	PC = concatenate2x8b(low, high);
+}
+
+void Processor::op_RTS(MemIO& mem, const OpInfo& op) {
+	unsigned char low = pull(mem);
+	unsigned char high = pull(mem);
+	PC = concatenate2x8b(low, high) + 1; // see JSR instruction, the saved address is the last byte of JSR
+}
+
+/* Store registers in memory (STA, STX, STY) ####*/
+template<AddrMode M> void Processor::op_STA(MemIO& mem, const OpInfo& op) { mem.write(operand_address<M>(mem), A); }
+template<AddrMode M> void Processor::op_STX(MemIO& mem, const OpInfo& op) { mem.write(operand_address<M>(mem), X); }
+template<AddrMode M> void Processor::op_STY(MemIO& mem, const OpInfo& op) { mem.write(operand_address<M>(mem), Y); }
+
+/* #### Register Tansfer instructions (TAX, TAY, TSX, TXA, TXS, TYA) ####*/
+void Processor::op_TAX(MemIO& mem, const OpInfo& op) { X = A; set_NZ(X); }
+void Processor::op_TAY(MemIO& mem, const OpInfo& op) { Y = A; set_NZ(Y); }
+void Processor::op_TSX(MemIO& mem, const OpInfo& op) { X = SP; set_NZ(X); }
+void Processor::op_TXA(MemIO& mem, const OpInfo& op) { A = X; set_NZ(A); }
+void Processor::op_TXS(MemIO& mem, const OpInfo& op) { SP = X; } //no flags set
+void Processor::op_TYA(MemIO& mem, const OpInfo& op) { A = Y; set_NZ(A); }
+
+void Processor::op_ILL(MemIO& mem, const OpInfo& op) { // not recognized opcode, skipped over like a NOP of its length
+	illegal_count++;
+}
+
+// ####### opcode dispatch table #####
+// One entry per opcode, kept by hand in step with 6502ops.csv (mnemonic, addressing, bytes, cycles), the cpu test
+// compares the two. Taking the address of each template instantiates a handler specialised for that opcode's mode.
+// Opcodes missing from the csv go to op_ILL, with the length and base cycles of the NMOS undocumented instruction so
+// PC and the clock stay in step with the real chip.
+
+const OpInfo Processor::op_table[256] = {
+	{ "BRK", AddrMode::IMP, 1, 7, &Processor::op_BRK }, // 0x00
+	{ "ORA", AddrMode::INDX, 2, 6, &Processor::op_alu<AddrMode::INDX, AluOp::ORA> }, // 0x01
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x02
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x03
+	{ "???", AddrMode::IMP, 2, 3, &Processor::op_ILL }, // 0x04
+	{ "ORA", AddrMode::ZP, 2, 3, &Processor::op_alu<AddrMode::ZP, AluOp::ORA> }, // 0x05
+	{ "ASL", AddrMode::ZP, 2, 5, &Processor::op_rmw<AddrMode::ZP, RmwOp::ASL> }, // 0x06
+	{ "???", AddrMode::IMP, 2, 5, &Processor::op_ILL }, // 0x07
+	{ "PHP", AddrMode::IMP, 1, 3, &Processor::op_PHP }, // 0x08
+	{ "ORA", AddrMode::IMM, 2, 2, &Processor::op_alu<AddrMode::IMM, AluOp::ORA> }, // 0x09
+	{ "ASL", AddrMode::ACC, 1, 2, &Processor::op_rmw_acc<RmwOp::ASL> }, // 0x0A
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x0B
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0x0C
+	{ "ORA", AddrMode::ABS, 3, 4, &Processor::op_alu<AddrMode::ABS, AluOp::ORA> }, // 0x0D
+	{ "ASL", AddrMode::ABS, 3, 6, &Processor::op_rmw<AddrMode::ABS, RmwOp::ASL> }, // 0x0E
+	{ "???", AddrMode::IMP, 3, 6, &Processor::op_ILL }, // 0x0F
+	{ "BPL", AddrMode::REL, 2, 2, &Processor::op_BPL }, // 0x10
+	{ "ORA", AddrMode::INDY, 2, 5, &Processor::op_alu<AddrMode::INDY, AluOp::ORA> }, // 0x11
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x12
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x13
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0x14
+	{ "ORA", AddrMode::ZPX, 2, 4, &Processor::op_alu<AddrMode::ZPX, AluOp::ORA> }, // 0x15
+	{ "ASL", AddrMode::ZPX, 2, 6, &Processor::op_rmw<AddrMode::ZPX, RmwOp::ASL> }, // 0x16
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0x17
+	{ "CLC", AddrMode::IMP, 1, 2, &Processor::op_CLC }, // 0x18
+	{ "ORA", AddrMode::ABSY, 3, 4, &Processor::op_alu<AddrMode::ABSY, AluOp::ORA> }, // 0x19
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x1A
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x1B
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0x1C
+	{ "ORA", AddrMode::ABSX, 3, 4, &Processor::op_alu<AddrMode::ABSX, AluOp::ORA> }, // 0x1D
+	{ "ASL", AddrMode::ABSX, 3, 7, &Processor::op_rmw<AddrMode::ABSX, RmwOp::ASL> }, // 0x1E
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x1F
+	{ "JSR", AddrMode::ABS, 3, 6, &Processor::op_JSR }, // 0x20
+	{ "AND", AddrMode::INDX, 2, 6, &Processor::op_alu<AddrMode::INDX, AluOp::AND> }, // 0x21
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x22
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x23
+	{ "BIT", AddrMode::ZP, 2, 3, &Processor::op_BIT<AddrMode::ZP> }, // 0x24
+	{ "AND", AddrMode::ZP, 2, 3, &Processor::op_alu<AddrMode::ZP, AluOp::AND> }, // 0x25
+	{ "ROL", AddrMode::ZP, 2, 5, &Processor::op_rmw<AddrMode::ZP, RmwOp::ROL> }, // 0x26
+	{ "???", AddrMode::IMP, 2, 5, &Processor::op_ILL }, // 0x27
+	{ "PLP", AddrMode::IMP, 1, 4, &Processor::op_PLP }, // 0x28
+	{ "AND", AddrMode::IMM, 2, 2, &Processor::op_alu<AddrMode::IMM, AluOp::AND> }, // 0x29
+	{ "ROL", AddrMode::ACC, 1, 2, &Processor::op_rmw_acc<RmwOp::ROL> }, // 0x2A
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x2B
+	{ "BIT", AddrMode::ABS, 3, 4, &Processor::op_BIT<AddrMode::ABS> }, // 0x2C
+	{ "AND", AddrMode::ABS, 3, 4, &Processor::op_alu<AddrMode::ABS, AluOp::AND> }, // 0x2D
+	{ "ROL", AddrMode::ABS, 3, 6, &Processor::op_rmw<AddrMode::ABS, RmwOp::ROL> }, // 0x2E
+	{ "???", AddrMode::IMP, 3, 6, &Processor::op_ILL }, // 0x2F
+	{ "BMI", AddrMode::REL, 2, 2, &Processor::op_BMI }, // 0x30
+	{ "AND", AddrMode::INDY, 2, 5, &Processor::op_alu<AddrMode::INDY, AluOp::AND> }, // 0x31
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x32
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x33
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0x34
+	{ "AND", AddrMode::ZPX, 2, 4, &Processor::op_alu<AddrMode::ZPX, AluOp::AND> }, // 0x35
+	{ "ROL", AddrMode::ZPX, 2, 6, &Processor::op_rmw<AddrMode::ZPX, RmwOp::ROL> }, // 0x36
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0x37
+	{ "SEC", AddrMode::IMP, 1, 2, &Processor::op_SEC }, // 0x38
+	{ "AND", AddrMode::ABSY, 3, 4, &Processor::op_alu<AddrMode::ABSY, AluOp::AND> }, // 0x39
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x3A
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x3B
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0x3C
+	{ "AND", AddrMode::ABSX, 3, 4, &Processor::op_alu<AddrMode::ABSX, AluOp::AND> }, // 0x3D
+	{ "ROL", AddrMode::ABSX, 3, 7, &Processor::op_rmw<AddrMode::ABSX, RmwOp::ROL> }, // 0x3E
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x3F
+	{ "RTI", AddrMode::IMP, 1, 6, &Processor::op_RTI }, // 0x40
+	{ "EOR", AddrMode::INDX, 2, 6, &Processor::op_alu<AddrMode::INDX, AluOp::EOR> }, // 0x41
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x42
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x43
+	{ "???", AddrMode::IMP, 2, 3, &Processor::op_ILL }, // 0x44
+	{ "EOR", AddrMode::ZP, 2, 3, &Processor::op_alu<AddrMode::ZP, AluOp::EOR> }, // 0x45
+	{ "LSR", AddrMode::ZP, 2, 5, &Processor::op_rmw<AddrMode::ZP, RmwOp::LSR> }, // 0x46
+	{ "???", AddrMode::IMP, 2, 5, &Processor::op_ILL }, // 0x47
+	{ "PHA", AddrMode::IMP, 1, 3, &Processor::op_PHA }, // 0x48
+	{ "EOR", AddrMode::IMM, 2, 2, &Processor::op_alu<AddrMode::IMM, AluOp::EOR> }, // 0x49
+	{ "LSR", AddrMode::ACC, 1, 2, &Processor::op_rmw_acc<RmwOp::LSR> }, // 0x4A
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x4B
+	{ "JMP", AddrMode::ABS, 3, 3, &Processor::op_JMP<AddrMode::ABS> }, // 0x4C
+	{ "EOR", AddrMode::ABS, 3, 4, &Processor::op_alu<AddrMode::ABS, AluOp::EOR> }, // 0x4D
+	{ "LSR", AddrMode::ABS, 3, 6, &Processor::op_rmw<AddrMode::ABS, RmwOp::LSR> }, // 0x4E
+	{ "???", AddrMode::IMP, 3, 6, &Processor::op_ILL }, // 0x4F
+	{ "BVC", AddrMode::REL, 2, 2, &Processor::op_BVC }, // 0x50
+	{ "EOR", AddrMode::INDY, 2, 5, &Processor::op_alu<AddrMode::INDY, AluOp::EOR> }, // 0x51
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x52
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x53
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0x54
+	{ "EOR", AddrMode::ZPX, 2, 4, &Processor::op_alu<AddrMode::ZPX, AluOp::EOR> }, // 0x55
+	{ "LSR", AddrMode::ZPX, 2, 6, &Processor::op_rmw<AddrMode::ZPX, RmwOp::LSR> }, // 0x56
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0x57
+	{ "CLI", AddrMode::IMP, 1, 2, &Processor::op_CLI }, // 0x58
+	{ "EOR", AddrMode::ABSY, 3, 4, &Processor::op_alu<AddrMode::ABSY, AluOp::EOR> }, // 0x59
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x5A
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x5B
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0x5C
+	{ "EOR", AddrMode::ABSX, 3, 4, &Processor::op_alu<AddrMode::ABSX, AluOp::EOR> }, // 0x5D
+	{ "LSR", AddrMode::ABSX, 3, 7, &Processor::op_rmw<AddrMode::ABSX, RmwOp::LSR> }, // 0x5E
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x5F
+	{ "RTS", AddrMode::IMP, 1, 6, &Processor::op_RTS }, // 0x60
+	{ "ADC", AddrMode::INDX, 2, 6, &Processor::op_alu<AddrMode::INDX, AluOp::ADC> }, // 0x61
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x62
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x63
+	{ "???", AddrMode::IMP, 2, 3, &Processor::op_ILL }, // 0x64
+	{ "ADC", AddrMode::ZP, 2, 3, &Processor::op_alu<AddrMode::ZP, AluOp::ADC> }, // 0x65
+	{ "ROR", AddrMode::ZP, 2, 5, &Processor::op_rmw<AddrMode::ZP, RmwOp::ROR> }, // 0x66
+	{ "???", AddrMode::IMP, 2, 5, &Processor::op_ILL }, // 0x67
+	{ "PLA", AddrMode::IMP, 1, 4, &Processor::op_PLA }, // 0x68
+	{ "ADC", AddrMode::IMM, 2, 2, &Processor::op_alu<AddrMode::IMM, AluOp::ADC> }, // 0x69
+	{ "ROR", AddrMode::ACC, 1, 2, &Processor::op_rmw_acc<RmwOp::ROR> }, // 0x6A
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x6B
+	{ "JMP", AddrMode::IND, 3, 5, &Processor::op_JMP<AddrMode::IND> }, // 0x6C
+	{ "ADC", AddrMode::ABS, 3, 4, &Processor::op_alu<AddrMode::ABS, AluOp::ADC> }, // 0x6D
+	{ "ROR", AddrMode::ABS, 3, 6, &Processor::op_rmw<AddrMode::ABS, RmwOp::ROR> }, // 0x6E
+	{ "???", AddrMode::IMP, 3, 6, &Processor::op_ILL }, // 0x6F
+	{ "BVS", AddrMode::REL, 2, 2, &Processor::op_BVS }, // 0x70
+	{ "ADC", AddrMode::INDY, 2, 5, &Processor::op_alu<AddrMode::INDY, AluOp::ADC> }, // 0x71
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x72
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0x73
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0x74
+	{ "ADC", AddrMode::ZPX, 2, 4, &Processor::op_alu<AddrMode::ZPX, AluOp::ADC> }, // 0x75
+	{ "ROR", AddrMode::ZPX, 2, 6, &Processor::op_rmw<AddrMode::ZPX, RmwOp::ROR> }, // 0x76
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0x77
+	{ "SEI", AddrMode::IMP, 1, 2, &Processor::op_SEI }, // 0x78
+	{ "ADC", AddrMode::ABSY, 3, 4, &Processor::op_alu<AddrMode::ABSY, AluOp::ADC> }, // 0x79
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x7A
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x7B
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0x7C
+	{ "ADC", AddrMode::ABSX, 3, 4, &Processor::op_alu<AddrMode::ABSX, AluOp::ADC> }, // 0x7D
+	{ "ROR", AddrMode::ABSX, 3, 7, &Processor::op_rmw<AddrMode::ABSX, RmwOp::ROR> }, // 0x7E
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0x7F
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x80
+	{ "STA", AddrMode::INDX, 2, 6, &Processor::op_STA<AddrMode::INDX> }, // 0x81
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x82
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0x83
+	{ "STY", AddrMode::ZP, 2, 3, &Processor::op_STY<AddrMode::ZP> }, // 0x84
+	{ "STA", AddrMode::ZP, 2, 3, &Processor::op_STA<AddrMode::ZP> }, // 0x85
+	{ "STX", AddrMode::ZP, 2, 3, &Processor::op_STX<AddrMode::ZP> }, // 0x86
+	{ "???", AddrMode::IMP, 2, 3, &Processor::op_ILL }, // 0x87
+	{ "DEY", AddrMode::IMP, 1, 2, &Processor::op_DEY }, // 0x88
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x89
+	{ "TXA", AddrMode::IMP, 1, 2, &Processor::op_TXA }, // 0x8A
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0x8B
+	{ "STY", AddrMode::ABS, 3, 4, &Processor::op_STY<AddrMode::ABS> }, // 0x8C
+	{ "STA", AddrMode::ABS, 3, 4, &Processor::op_STA<AddrMode::ABS> }, // 0x8D
+	{ "STX", AddrMode::ABS, 3, 4, &Processor::op_STX<AddrMode::ABS> }, // 0x8E
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0x8F
+	{ "BCC", AddrMode::REL, 2, 2, &Processor::op_BCC }, // 0x90
+	{ "STA", AddrMode::INDY, 2, 6, &Processor::op_STA<AddrMode::INDY> }, // 0x91
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0x92
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0x93
+	{ "STY", AddrMode::ZPX, 2, 4, &Processor::op_STY<AddrMode::ZPX> }, // 0x94
+	{ "STA", AddrMode::ZPX, 2, 4, &Processor::op_STA<AddrMode::ZPX> }, // 0x95
+	{ "STX", AddrMode::ZPY, 2, 4, &Processor::op_STX<AddrMode::ZPY> }, // 0x96
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0x97
+	{ "TYA", AddrMode::IMP, 1, 2, &Processor::op_TYA }, // 0x98
+	{ "STA", AddrMode::ABSY, 3, 5, &Processor::op_STA<AddrMode::ABSY> }, // 0x99
+	{ "TXS", AddrMode::IMP, 1, 2, &Processor::op_TXS }, // 0x9A
+	{ "???", AddrMode::IMP, 3, 5, &Processor::op_ILL }, // 0x9B
+	{ "???", AddrMode::IMP, 3, 5, &Processor::op_ILL }, // 0x9C
+	{ "STA", AddrMode::ABSX, 3, 5, &Processor::op_STA<AddrMode::ABSX> }, // 0x9D
+	{ "???", AddrMode::IMP, 3, 5, &Processor::op_ILL }, // 0x9E
+	{ "???", AddrMode::IMP, 3, 5, &Processor::op_ILL }, // 0x9F
+	{ "LDY", AddrMode::IMM, 2, 2, &Processor::op_LDY<AddrMode::IMM> }, // 0xA0
+	{ "LDA", AddrMode::INDX, 2, 6, &Processor::op_alu<AddrMode::INDX, AluOp::LDA> }, // 0xA1
+	{ "LDX", AddrMode::IMM, 2, 2, &Processor::op_LDX<AddrMode::IMM> }, // 0xA2
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0xA3
+	{ "LDY", AddrMode::ZP, 2, 3, &Processor::op_LDY<AddrMode::ZP> }, // 0xA4
+	{ "LDA", AddrMode::ZP, 2, 3, &Processor::op_alu<AddrMode::ZP, AluOp::LDA> }, // 0xA5
+	{ "LDX", AddrMode::ZP, 2, 3, &Processor::op_LDX<AddrMode::ZP> }, // 0xA6
+	{ "???", AddrMode::IMP, 2, 3, &Processor::op_ILL }, // 0xA7
+	{ "TAY", AddrMode::IMP, 1, 2, &Processor::op_TAY }, // 0xA8
+	{ "LDA", AddrMode::IMM, 2, 2, &Processor::op_alu<AddrMode::IMM, AluOp::LDA> }, // 0xA9
+	{ "TAX", AddrMode::IMP, 1, 2, &Processor::op_TAX }, // 0xAA
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0xAB
+	{ "LDY", AddrMode::ABS, 3, 4, &Processor::op_LDY<AddrMode::ABS> }, // 0xAC
+	{ "LDA", AddrMode::ABS, 3, 4, &Processor::op_alu<AddrMode::ABS, AluOp::LDA> }, // 0xAD
+	{ "LDX", AddrMode::ABS, 3, 4, &Processor::op_LDX<AddrMode::ABS> }, // 0xAE
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0xAF
+	{ "BCS", AddrMode::REL, 2, 2, &Processor::op_BCS }, // 0xB0
+	{ "LDA", AddrMode::INDY, 2, 5, &Processor::op_alu<AddrMode::INDY, AluOp::LDA> }, // 0xB1
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0xB2
+	{ "???", AddrMode::IMP, 2, 5, &Processor::op_ILL }, // 0xB3
+	{ "LDY", AddrMode::ZPX, 2, 4, &Processor::op_LDY<AddrMode::ZPX> }, // 0xB4
+	{ "LDA", AddrMode::ZPX, 2, 4, &Processor::op_alu<AddrMode::ZPX, AluOp::LDA> }, // 0xB5
+	{ "LDX", AddrMode::ZPY, 2, 4, &Processor::op_LDX<AddrMode::ZPY> }, // 0xB6
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0xB7
+	{ "CLV", AddrMode::IMP, 1, 2, &Processor::op_CLV }, // 0xB8
+	{ "LDA", AddrMode::ABSY, 3, 4, &Processor::op_alu<AddrMode::ABSY, AluOp::LDA> }, // 0xB9
+	{ "TSX", AddrMode::IMP, 1, 2, &Processor::op_TSX }, // 0xBA
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0xBB
+	{ "LDY", AddrMode::ABSX, 3, 4, &Processor::op_LDY<AddrMode::ABSX> }, // 0xBC
+	{ "LDA", AddrMode::ABSX, 3, 4, &Processor::op_alu<AddrMode::ABSX, AluOp::LDA> }, // 0xBD
+	{ "LDX", AddrMode::ABSY, 3, 4, &Processor::op_LDX<AddrMode::ABSY> }, // 0xBE
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0xBF
+	{ "CPY", AddrMode::IMM, 2, 2, &Processor::op_CPY<AddrMode::IMM> }, // 0xC0
+	{ "CMP", AddrMode::INDX, 2, 6, &Processor::op_alu<AddrMode::INDX, AluOp::CMP> }, // 0xC1
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0xC2
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0xC3
+	{ "CPY", AddrMode::ZP, 2, 3, &Processor::op_CPY<AddrMode::ZP> }, // 0xC4
+	{ "CMP", AddrMode::ZP, 2, 3, &Processor::op_alu<AddrMode::ZP, AluOp::CMP> }, // 0xC5
+	{ "DEC", AddrMode::ZP, 2, 5, &Processor::op_rmw<AddrMode::ZP, RmwOp::DEC> }, // 0xC6
+	{ "???", AddrMode::IMP, 2, 5, &Processor::op_ILL }, // 0xC7
+	{ "INY", AddrMode::IMP, 1, 2, &Processor::op_INY }, // 0xC8
+	{ "CMP", AddrMode::IMM, 2, 2, &Processor::op_alu<AddrMode::IMM, AluOp::CMP> }, // 0xC9
+	{ "DEX", AddrMode::IMP, 1, 2, &Processor::op_DEX }, // 0xCA
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0xCB
+	{ "CPY", AddrMode::ABS, 3, 4, &Processor::op_CPY<AddrMode::ABS> }, // 0xCC
+	{ "CMP", AddrMode::ABS, 3, 4, &Processor::op_alu<AddrMode::ABS, AluOp::CMP> }, // 0xCD
+	{ "DEC", AddrMode::ABS, 3, 6, &Processor::op_rmw<AddrMode::ABS, RmwOp::DEC> }, // 0xCE
+	{ "???", AddrMode::IMP, 3, 6, &Processor::op_ILL }, // 0xCF
+	{ "BNE", AddrMode::REL, 2, 2, &Processor::op_BNE }, // 0xD0
+	{ "CMP", AddrMode::INDY, 2, 5, &Processor::op_alu<AddrMode::INDY, AluOp::CMP> }, // 0xD1
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0xD2
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0xD3
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0xD4
+	{ "CMP", AddrMode::ZPX, 2, 4, &Processor::op_alu<AddrMode::ZPX, AluOp::CMP> }, // 0xD5
+	{ "DEC", AddrMode::ZPX, 2, 6, &Processor::op_rmw<AddrMode::ZPX, RmwOp::DEC> }, // 0xD6
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0xD7
+	{ "CLD", AddrMode::IMP, 1, 2, &Processor::op_CLD }, // 0xD8
+	{ "CMP", AddrMode::ABSY, 3, 4, &Processor::op_alu<AddrMode::ABSY, AluOp::CMP> }, // 0xD9
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0xDA
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0xDB
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0xDC
+	{ "CMP", AddrMode::ABSX, 3, 4, &Processor::op_alu<AddrMode::ABSX, AluOp::CMP> }, // 0xDD
+	{ "DEC", AddrMode::ABSX, 3, 7, &Processor::op_rmw<AddrMode::ABSX, RmwOp::DEC> }, // 0xDE
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0xDF
+	{ "CPX", AddrMode::IMM, 2, 2, &Processor::op_CPX<AddrMode::IMM> }, // 0xE0
+	{ "SBC", AddrMode::INDX, 2, 6, &Processor::op_alu<AddrMode::INDX, AluOp::SBC> }, // 0xE1
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0xE2
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0xE3
+	{ "CPX", AddrMode::ZP, 2, 3, &Processor::op_CPX<AddrMode::ZP> }, // 0xE4
+	{ "SBC", AddrMode::ZP, 2, 3, &Processor::op_alu<AddrMode::ZP, AluOp::SBC> }, // 0xE5
+	{ "INC", AddrMode::ZP, 2, 5, &Processor::op_rmw<AddrMode::ZP, RmwOp::INC> }, // 0xE6
+	{ "???", AddrMode::IMP, 2, 5, &Processor::op_ILL }, // 0xE7
+	{ "INX", AddrMode::IMP, 1, 2, &Processor::op_INX }, // 0xE8
+	{ "SBC", AddrMode::IMM, 2, 2, &Processor::op_alu<AddrMode::IMM, AluOp::SBC> }, // 0xE9
+	{ "NOP", AddrMode::IMP, 1, 2, &Processor::op_NOP }, // 0xEA
+	{ "???", AddrMode::IMP, 2, 2, &Processor::op_ILL }, // 0xEB
+	{ "CPX", AddrMode::ABS, 3, 4, &Processor::op_CPX<AddrMode::ABS> }, // 0xEC
+	{ "SBC", AddrMode::ABS, 3, 4, &Processor::op_alu<AddrMode::ABS, AluOp::SBC> }, // 0xED
+	{ "INC", AddrMode::ABS, 3, 6, &Processor::op_rmw<AddrMode::ABS, RmwOp::INC> }, // 0xEE
+	{ "???", AddrMode::IMP, 3, 6, &Processor::op_ILL }, // 0xEF
+	{ "BEQ", AddrMode::REL, 2, 2, &Processor::op_BEQ }, // 0xF0
+	{ "SBC", AddrMode::INDY, 2, 5, &Processor::op_alu<AddrMode::INDY, AluOp::SBC> }, // 0xF1
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0xF2
+	{ "???", AddrMode::IMP, 2, 8, &Processor::op_ILL }, // 0xF3
+	{ "???", AddrMode::IMP, 2, 4, &Processor::op_ILL }, // 0xF4
+	{ "SBC", AddrMode::ZPX, 2, 4, &Processor::op_alu<AddrMode::ZPX, AluOp::SBC> }, // 0xF5
+	{ "INC", AddrMode::ZPX, 2, 6, &Processor::op_rmw<AddrMode::ZPX, RmwOp::INC> }, // 0xF6
+	{ "???", AddrMode::IMP, 2, 6, &Processor::op_ILL }, // 0xF7
+	{ "SED", AddrMode::IMP, 1, 2, &Processor::op_SED }, // 0xF8
+	{ "SBC", AddrMode::ABSY, 3, 4, &Processor::op_alu<AddrMode::ABSY, AluOp::SBC> }, // 0xF9
+	{ "???", AddrMode::IMP, 1, 2, &Processor::op_ILL }, // 0xFA
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0xFB
+	{ "???", AddrMode::IMP, 3, 4, &Processor::op_ILL }, // 0xFC
+	{ "SBC", AddrMode::ABSX, 3, 4, &Processor::op_alu<AddrMode::ABSX, AluOp::SBC> }, // 0xFD
+	{ "INC", AddrMode::ABSX, 3, 7, &Processor::op_rmw<AddrMode::ABSX, RmwOp::INC> }, // 0xFE
+	{ "???", AddrMode::IMP, 3, 7, &Processor::op_ILL }, // 0xFF
+};
@@ -1,9 +1,26 @@
-
-
 #pragma once
 #define CPU_H
 
 #include "memory.h"
+#include "trace.h"
+#include "snapshot.h"
+
+enum class AddrMode { IMP, ACC, IMM, ZP, ZPX, ZPY, ABS, ABSX, ABSY, IND, INDX, INDY, REL }; //addressing modes, as named in 6502ops.csv
+enum class AluOp { ADC, AND, CMP, EOR, LDA, ORA, SBC }; //operations combining the accumulator with a memory operand
+enum class RmwOp { ASL, LSR, ROL, ROR, INC, DEC }; //read-modify-write operations
+
+class Processor;
+class JitCache;
+struct OpInfo;
+typedef void (Processor::*OpHandler)(MemIO& mem, const OpInfo& op); //instruction handler, called with PC already past the opcode byte
+
+struct OpInfo { //one entry of the opcode dispatch table, mirrors a line of 6502ops.csv
+	const char* mnemonic;
+	AddrMode mode;
+	unsigned char bytes; //instruction length, opcode included
+	unsigned char cycles; //base cycle count, page crossings and taken branches add to it
+	OpHandler handler;
+};
 
 
 class Processor {
@@ -12,14 +29,24 @@ public:
 	int step; //counting the cycle on which the CPU is currently on
 	bool waiting; //flag, set to TRUE if processor is waiting (ex: RDY pin asserted by TIA)
 	//constructor
-	Processor(MemIO mem); 
+	Processor(MemIO& mem);
+	~Processor();
+	Processor(const Processor&) = delete; //owns its decode cache
+	Processor& operator=(const Processor&) = delete;
 	//main methods
-	void cpu_tick(MemIO mem); //run one clock cycle of the 6502 processor
+	void cpu_tick(MemIO& mem); //run one clock cycle of the 6502 processor
+	unsigned long long run_cycles(MemIO& mem, unsigned long long budget); //run whole instructions for at least budget cycles, returns cycles run
+	bool run_until_frame(MemIO& mem); //run until the program starts VSYNC, FALSE if it never did within MemIO::MAX_FRAME_CYCLES
 	void sleep(); //RDY pin asserted
 	void wake(); //RDY pin unasserted, eg Hblank.
-	void reset(MemIO mem); //resetting
+	void reset(MemIO& mem); //resetting
 	void dump_registers(); //prints register contents
-	
+	void set_trace(TraceBuffer* buffer); //attach an instruction trace buffer (only recorded in CPU_TRACE builds), NULL turns tracing off
+	void set_idle_skip(bool enabled); //fast-forward loops that only poll the timer or inputs in run_cycles/run_until_frame, on by default
+	void set_jit(bool enabled); //translate hot ROM code to native code in run_cycles/run_until_frame, x86-64 only, off by default
+	void save_state(CpuState& state) const; //registers and the cpu_tick position, see snapshot.h
+	void load_state(const CpuState& state);
+
 	//registers
 	unsigned char A; //accumulator
 	unsigned char X;
@@ -28,21 +55,174 @@ public:
 	unsigned short PC; // Program counter;
 	//flag registers
 	bool C; //M0 Carry flag
-	bool Z; //M1 Zero flag
 	bool I; //M2 Interrupt flag (disabled on 6507)
 	bool D; //M3 Decimal/BCD flag (disabled on 6507?)
 	bool B_h; //M4/M5 Break flag, ???
 	bool B_l; //M4/M5 Break flag, ???
 	bool V; //M6 Overflow flag
-	bool N; // M7Negative flag
+	//N and Z are lazy: instructions store the byte the flag comes from and it is only tested when read. Two bytes
+	//rather than one because BIT and PLP/RTI can set both flags together
+	unsigned char Z_result; //M1 Zero flag is set when this is 0
+	unsigned char N_result; //M7 Negative flag is bit 7 of this
+	bool Z() const { return Z_result == 0; }
+	bool N() const { return N_result & 0x80; }
+	unsigned char SR() const; //packed status register, break bits as latched
+
+	static const OpInfo op_table[256]; //opcode dispatch table, indexed by opcode
+	unsigned long long illegal_count; //undocumented opcodes run since construction
 private:
 	//private methods within compute loop
-	void compute(unsigned char opcode, MemIO mem); //execute the operation. Currenty public for initial debugging, set to private once done!
+	void compute(MemIO& mem); //execute the operation and set step to its remaining cycles
+	int execute(MemIO& mem); //fetch, decode and run one instruction, returns its cycle count
 	void wait();
-	
+	int halt_until_hblank(MemIO& mem); //WSYNC handling
 
-};
+	TraceBuffer* trace; //instruction trace sink, NULL when tracing is off
+
+	//code caches. Each entry keeps the MemIO::map_generation it was made under and the pages it looked at, and is stale
+	//once one of those pages has been remapped since. Entries start at generation 0, older than every page
+	struct PageSet { //pages a cached analysis depends on
+		static const int MAX = 8;
+		unsigned char page[MAX];
+		unsigned char count;
+		bool add(unsigned short first, int size); //every page of [first, first + size), FALSE when they do not fit
+		bool remapped(const MemIO& mem, unsigned int generation) const {
+			for (int i = 0; i < count; i++) {
+				if (mem.remapped_since(page[i], generation)) { return 1; }
+			}
+			return 0;
+		}
+	};
+	unsigned int cache_epoch; //MemIO::cache_epoch the caches below were filled under
+	void drop_caches(MemIO& mem); //the map generation wrapped, forget everything
 
+	//idle loop skipping
+	struct IdleLoop { //a backward branch and the loop body it closes, analysed once
+		unsigned short branch_pc; //address of the branch opcode, 0 for an empty slot
+		unsigned short head; //branch target
+		unsigned int generation; //MemIO::map_generation when analysed, a bank switch may have changed the code
+		PageSet pages; //body and the fixed addresses it reads
+		bool idle; //body only reads RAM, ROM, the RIOT or the TIA inputs and writes nothing
+		bool reads_timer; //body reads INTIM or TIMINT, so it can only be skipped up to the next timer tick
+		int body_cycles; //one pass without the branch-taken cycles
+		bool armed; //registers below were saved on the previous pass
+		unsigned long long last_cycle; //clock when the branch was last taken
+		unsigned char A, X, Y, SP, SR; //registers when the branch was last taken
+	};
+	static const int IDLE_SLOTS = 16; //direct mapped on the branch address
+	static const int IDLE_MAX_BODY = 32; //longest loop body analysed, in bytes
+	IdleLoop idle_loops[IDLE_SLOTS];
+	bool idle_skip;
+	unsigned long long skip_limit; //clock that idle skipping must not jump past, set by the run_ entry points (0 outside them)
+	void skip_idle_loop(MemIO& mem, unsigned short branch_pc); //called on a taken backward branch
+	void analyse_loop(MemIO& mem, IdleLoop& loop); //fills idle, reads_timer and body_cycles
+
+	//decode cache. Cartridge ROM only changes on a bank switch, so its instructions are decoded once and kept per
+	//address until a page they sit on is remapped. Code in RAM or on hooked pages always goes through the opcode table
+	struct DecodedOp { //one ROM instruction, ready to run
+		OpHandler handler; //NULL: not cacheable (a byte sits on a page that is not plain ROM)
+		unsigned int generation; //MemIO::map_generation when decoded
+		unsigned short operand; //operand bytes, little endian. For absolute modes this is the effective address
+		unsigned char bytes;
+		unsigned char cycles;
+		unsigned char opcode;
+	};
+	static const int DECODE_SLOTS = 0x1000; //one per address of $1000-$1FFF
+	DecodedOp* decoded;
+	void decode(MemIO& mem, unsigned short address, DecodedOp& d);
+	bool stale(const MemIO& mem, unsigned short address, const DecodedOp& d) const { //the page of its first or last byte was remapped
+		return mem.remapped_since(address >> MemIO::PAGE_BITS, d.generation) || mem.remapped_since(((address + d.bytes - 1) & MemIO::ADDRESS_MASK) >> MemIO::PAGE_BITS, d.generation);
+	}
+	int run_decoded(MemIO& mem, const DecodedOp& d); //execute() for a cached instruction, no opcode table or operand fetch
+
+	//basic blocks. A block is the straight-line ROM code from one address up to and including the first instruction
+	//that may leave it (branch, jump, call, return, BRK) or reach a device (TIA, RIOT, hooked cartridge page, the stack
+	//or any address only known at run time). Only that last instruction can halt the CPU, start a frame or switch banks,
+	//so the run loops check their budget and flags once per block instead of once per instruction
+	struct CodeBlock { //one per start address, alongside decoded
+		unsigned int generation; //MemIO::map_generation when built
+		PageSet pages; //code and operand pages
+		unsigned short cycles; //summed base cycles
+		unsigned char crossings; //instructions that may add a page crossing cycle
+		unsigned char count; //instructions, 0: the first one is not cacheable
+	};
+	static const int BLOCK_MAX_OPS = 32;
+	CodeBlock* blocks;
+	void build_block(MemIO& mem, unsigned short address, CodeBlock& b);
+	void run_block(MemIO& mem, unsigned long long end); //the block at PC if it surely starts all its instructions before end, else one instruction
+
+	JitCache* jit; //native tier in front of the blocks, NULL when off
+
+	unsigned short operand; //operand bytes of the current instruction, fetched before its handler runs
+	int extra_cycles; //cycles added to the base count by the current instruction (page crossing, branch taken)
+	bool page_crossed; //set by operand_address when indexing crossed a page boundary
+
+	//addressing modes, specialised per mode so every handler below is compiled for one fixed mode
+	template<AddrMode M> unsigned short operand_address(MemIO& mem); //effective address of the operand
+	template<AddrMode M> unsigned char fetch_operand(MemIO& mem); //value of the operand for read instructions, pays the page crossing cycle
+	//stack
+	void push(MemIO& mem, unsigned char value);
+	unsigned char pull(MemIO& mem);
+	//shared ALU behaviour
+	void set_NZ(unsigned char value);
+	void do_compare(unsigned char reg, unsigned char value);
+	template<AluOp Op> void alu(unsigned char value);
+	void decimal_result(unsigned char result, unsigned char flags); //decimal ADC/SBC outcome from the BCD tables
+	template<RmwOp Op> unsigned char rmw(unsigned char value);
+	void branch(MemIO& mem, bool condition);
+	void unpack_SR(unsigned char SR);
+
+	//instruction handlers. Moded instructions are templates instantiated once per opcode by op_table
+	template<AddrMode M, AluOp Op> void op_alu(MemIO& mem, const OpInfo& op); //ADC, AND, CMP, EOR, LDA, ORA, SBC
+	template<AddrMode M, RmwOp Op> void op_rmw(MemIO& mem, const OpInfo& op); //ASL, LSR, ROL, ROR, INC, DEC on memory
+	template<RmwOp Op> void op_rmw_acc(MemIO& mem, const OpInfo& op); //ASL, LSR, ROL, ROR on A
+	void op_BCC(MemIO& mem, const OpInfo& op);
+	void op_BCS(MemIO& mem, const OpInfo& op);
+	void op_BEQ(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_BIT(MemIO& mem, const OpInfo& op);
+	void op_BMI(MemIO& mem, const OpInfo& op);
+	void op_BNE(MemIO& mem, const OpInfo& op);
+	void op_BPL(MemIO& mem, const OpInfo& op);
+	void op_BRK(MemIO& mem, const OpInfo& op);
+	void op_BVC(MemIO& mem, const OpInfo& op);
+	void op_BVS(MemIO& mem, const OpInfo& op);
+	void op_CLC(MemIO& mem, const OpInfo& op);
+	void op_CLD(MemIO& mem, const OpInfo& op);
+	void op_CLI(MemIO& mem, const OpInfo& op);
+	void op_CLV(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_CPX(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_CPY(MemIO& mem, const OpInfo& op);
+	void op_DEX(MemIO& mem, const OpInfo& op);
+	void op_DEY(MemIO& mem, const OpInfo& op);
+	void op_INX(MemIO& mem, const OpInfo& op);
+	void op_INY(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_JMP(MemIO& mem, const OpInfo& op);
+	void op_JSR(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_LDX(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_LDY(MemIO& mem, const OpInfo& op);
+	void op_NOP(MemIO& mem, const OpInfo& op);
+	void op_PHA(MemIO& mem, const OpInfo& op);
+	void op_PHP(MemIO& mem, const OpInfo& op);
+	void op_PLA(MemIO& mem, const OpInfo& op);
+	void op_PLP(MemIO& mem, const OpInfo& op);
+	void op_RTI(MemIO& mem, const OpInfo& op);
+	void op_RTS(MemIO& mem, const OpInfo& op);
+	void op_SEC(MemIO& mem, const OpInfo& op);
+	void op_SED(MemIO& mem, const OpInfo& op);
+	void op_SEI(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_STA(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_STX(MemIO& mem, const OpInfo& op);
+	template<AddrMode M> void op_STY(MemIO& mem, const OpInfo& op);
+	void op_TAX(MemIO& mem, const OpInfo& op);
+	void op_TAY(MemIO& mem, const OpInfo& op);
+	void op_TSX(MemIO& mem, const OpInfo& op);
+	void op_TXA(MemIO& mem, const OpInfo& op);
+	void op_TXS(MemIO& mem, const OpInfo& op);
+	void op_TYA(MemIO& mem, const OpInfo& op);
+	void op_ILL(MemIO& mem, const OpInfo& op); //opcode not in 6502ops.csv
+
+
+};
 
 
 
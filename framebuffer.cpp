@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "framebuffer.h"
+
+static int align_up(int bytes) {
+	return (bytes + FRAME_ALIGNMENT - 1) & ~(FRAME_ALIGNMENT - 1);
+}
+
+unsigned char* aligned_block(size_t bytes) { //zeroed, FRAME_ALIGNMENT aligned
+	void* block = NULL;
+#if defined(_MSC_VER)
+	block = _aligned_malloc(bytes, FRAME_ALIGNMENT);
+#else
+	if (posix_memalign(&block, FRAME_ALIGNMENT, bytes) != 0) { block = NULL; }
+#endif
+	if (block != NULL) { memset(block, 0, bytes); }
+	return (unsigned char*)block;
+}
+
+void free_block(unsigned char* block) {
+#if defined(_MSC_VER)
+	_aligned_free(block);
+#else
+	free(block);
+#endif
+}
+
+FrameBuffer::FrameBuffer(int width, int height) {
+	this->width = width;
+	this->height = height;
+	stride = align_up(width);
+	rgba_stride = align_up(width * 4);
+	indexed[0] = aligned_block((size_t)stride * height);
+	indexed[1] = aligned_block((size_t)stride * height);
+	rgba[0] = NULL;
+	rgba[1] = NULL;
+	memset(rgba_palette, 0, sizeof(rgba_palette));
+	back = 0;
+	frames = 0;
+}
+
+FrameBuffer::~FrameBuffer() {
+	free_block(indexed[0]);
+	free_block(indexed[1]);
+	free_block(rgba[0]);
+	free_block(rgba[1]);
+}
+
+void FrameBuffer::enable_rgba(const unsigned int* palette) {
+	for (int color = 0; color < 256; color++) {
+		unsigned char bytes[4] = { (unsigned char)(palette[color] >> 16), (unsigned char)(palette[color] >> 8), (unsigned char)palette[color], 0xFF };
+		memcpy(&rgba_palette[color], bytes, 4); //stored as it will be laid out in memory, whatever the host endianness
+	}
+	if (rgba[0] == NULL) {
+		rgba[0] = aligned_block((size_t)rgba_stride * height);
+		rgba[1] = aligned_block((size_t)rgba_stride * height);
+	}
+}
+
+void FrameBuffer::present(int lines_drawn) {
+	if (lines_drawn < 0) { lines_drawn = 0; }
+	if (lines_drawn < height) { //short frame, lines below the last one drawn still hold an older frame
+		memset(indexed[back] + lines_drawn * stride, 0, (size_t)(height - lines_drawn) * stride);
+	}
+	if (rgba[back] != NULL) {
+		for (int line = 0; line < height; line++) {
+			const unsigned char* src = indexed[back] + line * stride;
+			unsigned int* dst = (unsigned int*)(rgba[back] + line * rgba_stride);
+			for (int x = 0; x < width; x++) { dst[x] = rgba_palette[src[x]]; }
+		}
+	}
+	back = back ^ 1;
+	frames = frames + 1;
+}
+
+void FrameBuffer::clear() {
+	for (int i = 0; i < 2; i++) {
+		memset(indexed[i], 0, (size_t)stride * height);
+		if (rgba[i] != NULL) { memset(rgba[i], 0, (size_t)rgba_stride * height); }
+	}
+	back = 0;
+	frames = 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#define FRAMEBUFFER_H
+
+#include <cstddef>
+
+// Video output. Each frame is one contiguous 64-byte-aligned block with a fixed stride: an indexed plane holding the
+// 2600 color codes, and optionally a packed RGBA plane (bytes R, G, B, A) filled from the palette when a frame is done.
+// Two frames are kept: the TIA draws into the back one while the front one, the last completed frame, can be read
+// (or wrapped in a cv::Mat) without copying until the next present().
+
+static const int FRAME_ALIGNMENT = 64; //cache line, also enough for any SIMD load
+unsigned char* aligned_block(size_t bytes); //zeroed block, FRAME_ALIGNMENT aligned, release with free_block
+void free_block(unsigned char* block);
+
+class FrameBuffer {
+public:
+	FrameBuffer(int width, int height);
+	~FrameBuffer();
+	FrameBuffer(const FrameBuffer&) = delete;
+	FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+	int width; //pixels per line, blanking included
+	int height; //lines per frame
+	int stride; //bytes from one line to the next in the indexed plane, multiple of 64
+	int rgba_stride; //bytes from one line to the next in the RGBA plane, multiple of 64
+
+	unsigned char* row(int line) { return indexed[back] + line * stride; } //line of the frame being drawn
+	const unsigned char* front() const { return indexed[back ^ 1]; } //last completed frame, indexed colors
+	const unsigned char* front_rgba() const { return rgba[back ^ 1]; } //last completed frame as RGBA, NULL unless enable_rgba was called
+
+	void enable_rgba(const unsigned int* palette); //allocate the RGBA planes, palette holds 0xRRGGBB for each of the 256 color codes
+	void present(int lines_drawn); //blank lines the frame never reached, convert it to RGBA if enabled and make it the front frame
+	void clear(); //both frames blank and the count at zero, as constructed
+	unsigned long long frames; //number of frames presented
+
+private:
+	unsigned char* indexed[2];
+	unsigned char* rgba[2];
+	unsigned int rgba_palette[256]; //color code to packed RGBA, in memory byte order
+	int back; //index of the frame being drawn
+};
@@ -0,0 +1,484 @@
+#include <iostream>
+#include <cstring>
+
+#include "jit.h"
+#include "cpu.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// ####### x86-64 emitter #####
+// Just the encodings the translator needs. Guest registers are pinned: A in r12, X in r13, Y in r14, the pending N/Z
+// result in r8, C in r9, V in r10, page crossings counted in r15, JitRegisters* in rbx, memory operands through rdx.
+
+enum HostReg { RAX = 0, RCX = 1, RDX = 2, RBX = 3, R8 = 8, R9 = 9, R10 = 10, R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+
+static const int REG_A = R12;
+static const int REG_X = R13;
+static const int REG_Y = R14;
+static const int REG_NZ = R8;
+static const int REG_C = R9;
+static const int REG_V = R10;
+
+enum HostAlu { ALU_ADD = 0, ALU_OR = 1, ALU_ADC = 2, ALU_SBB = 3, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7 }; //x86 group 1 order
+enum HostShift { SHIFT_RCL = 2, SHIFT_RCR = 3, SHIFT_SHL = 4, SHIFT_SHR = 5 }; //x86 group 2 order
+enum HostCond { COND_O = 0x0, COND_C = 0x2, COND_NC = 0x3, COND_A = 0x7 };
+
+struct Emitter {
+	unsigned char* code;
+	int size;
+	int capacity;
+
+	Emitter(unsigned char* buffer, int capacity) : code(buffer), size(0), capacity(capacity) {}
+
+	void byte(unsigned char b) {
+		if (size < capacity) { code[size] = b; }
+		size = size + 1; //keeps counting past the end, the translator checks size against its buffer
+	}
+	void rex(bool wide, int reg, int index, int rm) { //only emitted when needed, no byte register used here is one of spl..dil
+		unsigned char r = 0x40 | (wide << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (rm >> 3);
+		if (r != 0x40) { byte(r); }
+	}
+	void reg_reg(int reg, int rm) { byte(0xC0 | ((reg & 7) << 3) | (rm & 7)); }
+	void memory(int reg, int index) { //[rdx] or [rdx + index]
+		if (index == 0) { byte(((reg & 7) << 3) | RDX); return; }
+		byte(((reg & 7) << 3) | 0x04);
+		byte(((index & 7) << 3) | RDX);
+	}
+	void state(int reg, int offset) { byte(0x40 | ((reg & 7) << 3) | RBX); byte(offset); } //[rbx + disp8]
+
+	//8-bit register and memory forms
+	void alu_reg_imm(HostAlu op, int reg, unsigned char value) { rex(0, 0, 0, reg); byte(0x80); reg_reg(op, reg); byte(value); }
+	void alu_reg_mem(HostAlu op, int reg, int index) { rex(0, reg, index, RDX); byte((op << 3) | 0x02); memory(reg, index); }
+	void alu_reg_reg(HostAlu op, int dst, int src) { rex(0, src, 0, dst); byte(op << 3); reg_reg(src, dst); }
+	void mov_reg_imm(int reg, unsigned char value) { rex(0, 0, 0, reg); byte(0xB0 | (reg & 7)); byte(value); }
+	void mov_reg_reg(int dst, int src) { rex(0, src, 0, dst); byte(0x88); reg_reg(src, dst); }
+	void mov_reg_mem(int reg, int index) { rex(0, reg, index, RDX); byte(0x8A); memory(reg, index); }
+	void mov_mem_reg(int index, int reg) { rex(0, reg, index, RDX); byte(0x88); memory(reg, index); }
+	void mov_reg_state(int reg, int offset) { rex(0, reg, 0, RBX); byte(0x8A); state(reg, offset); }
+	void mov_state_reg(int offset, int reg) { rex(0, reg, 0, RBX); byte(0x88); state(reg, offset); }
+	void inc_reg(int reg, bool decrement) { rex(0, 0, 0, reg); byte(0xFE); reg_reg(decrement, reg); }
+	void inc_mem(int index, bool decrement) { rex(0, 0, index, RDX); byte(0xFE); memory(decrement, index); }
+	void shift_reg(HostShift op, int reg) { rex(0, 0, 0, reg); byte(0xD0); reg_reg(op, reg); }
+	void shift_mem(HostShift op, int index) { rex(0, 0, index, RDX); byte(0xD0); memory(op, index); }
+	void setcc_reg(HostCond cond, int reg) { rex(0, 0, 0, reg); byte(0x0F); byte(0x90 | cond); reg_reg(0, reg); }
+
+	//32 and 64-bit forms
+	void movzx_state(int reg, int offset) { rex(0, reg, 0, RBX); byte(0x0F); byte(0xB6); state(reg, offset); }
+	void movzx_reg(int dst, int src) { rex(0, dst, 0, src); byte(0x0F); byte(0xB6); reg_reg(dst, src); }
+	void zero(int reg) { rex(0, reg, 0, reg); byte(0x31); reg_reg(reg, reg); }
+	void bt_carry() { rex(0, 0, 0, REG_C); byte(0x0F); byte(0xBA); reg_reg(4, REG_C); byte(0); } //CF = guest C
+	void cmc() { byte(0xF5); }
+	void mov_rdx_pointer(const void* pointer) {
+		unsigned long long value = (unsigned long long)pointer;
+		byte(0x48); byte(0xBA);
+		for (int i = 0; i < 8; i++) { byte(value >> (8 * i)); }
+	}
+	void add_r15_rax() { byte(0x49); byte(0x01); byte(0xC7); }
+	void mov_state_r15(int offset) { byte(0x4C); byte(0x89); state(R15, offset); }
+	void push(int reg) { rex(0, 0, 0, reg); byte(0x50 | (reg & 7)); }
+	void pop(int reg) { rex(0, 0, 0, reg); byte(0x58 | (reg & 7)); }
+	void mov_rbx_argument() { //first integer argument
+		byte(0x48); byte(0x89);
+#ifdef _WIN32
+		reg_reg(RCX, RBX);
+#else
+		reg_reg(7, RBX); //rdi
+#endif
+	}
+	void ret() { byte(0xC3); }
+};
+
+// ####### translation #####
+// Every guest instruction becomes a few host instructions with its operand baked in, flags are only computed where the
+// 6502 defines them. The interpreter pays a page crossing cycle on indexed reads, here it is counted into r15.
+
+enum JitKind { K_NONE, K_LOAD, K_STORE, K_ALU, K_COMPARE, K_ADC, K_SBC, K_BIT, K_STEP, K_SHIFT, K_TRANSFER, K_TSX, K_TXS, K_CLC, K_SEC, K_CLV, K_NOP };
+
+struct JitOp { //how a mnemonic is translated
+	const char* mnemonic;
+	JitKind kind;
+	int reg; //guest register involved (destination of transfers)
+	int arg; //HostAlu, HostShift, decrement flag or transfer source
+};
+
+static const JitOp jit_ops[] = {
+	{ "LDA", K_LOAD, REG_A, 0 }, { "LDX", K_LOAD, REG_X, 0 }, { "LDY", K_LOAD, REG_Y, 0 },
+	{ "STA", K_STORE, REG_A, 0 }, { "STX", K_STORE, REG_X, 0 }, { "STY", K_STORE, REG_Y, 0 },
+	{ "AND", K_ALU, REG_A, ALU_AND }, { "ORA", K_ALU, REG_A, ALU_OR }, { "EOR", K_ALU, REG_A, ALU_XOR },
+	{ "CMP", K_COMPARE, REG_A, 0 }, { "CPX", K_COMPARE, REG_X, 0 }, { "CPY", K_COMPARE, REG_Y, 0 },
+	{ "ADC", K_ADC, REG_A, 0 }, { "SBC", K_SBC, REG_A, 0 }, { "BIT", K_BIT, REG_A, 0 },
+	{ "INC", K_STEP, 0, 0 }, { "DEC", K_STEP, 0, 1 },
+	{ "INX", K_STEP, REG_X, 0 }, { "INY", K_STEP, REG_Y, 0 }, { "DEX", K_STEP, REG_X, 1 }, { "DEY", K_STEP, REG_Y, 1 },
+	{ "ASL", K_SHIFT, 0, SHIFT_SHL }, { "LSR", K_SHIFT, 0, SHIFT_SHR }, { "ROL", K_SHIFT, 0, SHIFT_RCL }, { "ROR", K_SHIFT, 0, SHIFT_RCR },
+	{ "TAX", K_TRANSFER, REG_X, REG_A }, { "TAY", K_TRANSFER, REG_Y, REG_A }, { "TXA", K_TRANSFER, REG_A, REG_X }, { "TYA", K_TRANSFER, REG_A, REG_Y },
+	{ "TSX", K_TSX, REG_X, 0 }, { "TXS", K_TXS, REG_X, 0 },
+	{ "CLC", K_CLC, 0, 0 }, { "SEC", K_SEC, 0, 0 }, { "CLV", K_CLV, 0, 0 }, { "CLD", K_NOP, 0, 0 }, { "NOP", K_NOP, 0, 0 },
+};
+
+static const JitOp* find_jit_op(const char* mnemonic) {
+	for (unsigned int i = 0; i < sizeof(jit_ops) / sizeof(jit_ops[0]); i++) {
+		if (strcmp(mnemonic, jit_ops[i].mnemonic) == 0) { return &jit_ops[i]; }
+	}
+	return NULL;
+}
+
+struct JitOperand { //memory operand resolved to host memory
+	unsigned char* pointer; //byte at the base address
+	int index; //0, REG_X or REG_Y
+};
+
+static const int STATE_A = 0; //JitRegisters offsets
+static const int STATE_X = 1;
+static const int STATE_Y = 2;
+static const int STATE_SP = 3;
+static const int STATE_C = 4;
+static const int STATE_Z_RESULT = 5;
+static const int STATE_N_RESULT = 6;
+static const int STATE_V = 7;
+static const int STATE_EXTRA = 8;
+
+JitCache::JitCache() {
+	translations = 0;
+	native_runs = 0;
+	entries = new Entry[0x1000]; //$1000-$1FFF
+	for (int i = 0; i < 0x1000; i++) {
+		entries[i].translation = NULL;
+		entries[i].generation = 0;
+		entries[i].heat = 0;
+	}
+	arena_used = 0;
+#ifdef _WIN32
+	arena = (unsigned char*)VirtualAlloc(NULL, ARENA_BYTES, MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READ);
+#else
+	void* block = mmap(NULL, ARENA_BYTES, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	arena = (block == MAP_FAILED) ? NULL : (unsigned char*)block;
+#endif
+	if (arena == NULL) { std::cerr << "JIT: no executable memory, staying interpreted" << std::endl; }
+}
+
+JitCache::~JitCache() {
+	delete[] entries;
+	if (arena == NULL) { return; }
+#ifdef _WIN32
+	VirtualFree(arena, 0, MEM_RELEASE);
+#else
+	munmap(arena, ARENA_BYTES);
+#endif
+}
+
+void JitCache::flush() {
+	for (int i = 0; i < 0x1000; i++) {
+		entries[i].translation = NULL;
+		entries[i].generation = 0;
+		entries[i].heat = 0;
+	}
+	arena_used = 0;
+}
+
+void JitCache::make_writable(bool writable) { //W^X: the arena is never writable and executable at once
+#ifdef _WIN32
+	DWORD old;
+	VirtualProtect(arena, ARENA_BYTES, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &old);
+	if (!writable) { FlushInstructionCache(GetCurrentProcess(), arena, ARENA_BYTES); }
+#else
+	mprotect(arena, ARENA_BYTES, writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC));
+#endif
+}
+
+bool JitCache::remapped(const MemIO& mem, const Translation& t, unsigned int generation) const {
+	for (int i = 0; i < t.dependency_count; i++) {
+		if (mem.remapped_since(t.dependencies[i].page, generation)) { return 1; }
+	}
+	return 0;
+}
+
+bool JitCache::still_mapped(const MemIO& mem, const Translation& t) const {
+	if (mem.cart == NULL) { return 0; } //plain ROM in mem_array can be poked in place, only the generation vouches for it
+	for (int i = 0; i < t.dependency_count; i++) {
+		const JitDependency& d = t.dependencies[i];
+		if ((mem.read_page[d.page] != d.read) || (mem.write_page[d.page] != d.write)) { return 0; }
+	}
+	return 1;
+}
+
+bool JitCache::run(Processor& cpu, MemIO& mem, unsigned long long end) {
+	unsigned short address = cpu.PC & MemIO::ADDRESS_MASK;
+	if (!(address & 0x1000) || (arena == NULL)) { return 0; }
+	Entry& e = entries[address & 0x0FFF];
+	if (e.translation == NULL) {
+		if (e.heat < JIT_THRESHOLD) {
+			e.heat = e.heat + 1;
+			if (e.heat < JIT_THRESHOLD) { return 0; }
+		}
+		else if (!mem.remapped_since(address >> MemIO::PAGE_BITS, e.generation)) { return 0; } //already failed, the code here has not moved since
+		e.generation = mem.map_generation;
+		e.translation = translate(mem, address);
+		if (e.translation == NULL) { return 0; }
+	}
+	else if (remapped(mem, *e.translation, e.generation)) { //a bank switch, the code may still be the same
+		if (!still_mapped(mem, *e.translation)) {
+			e.translation = NULL;
+			e.heat = 0;
+			return 0;
+		}
+		e.generation = mem.map_generation;
+	}
+	const Translation& t = *e.translation;
+	if (mem.cycles + t.cycles + t.crossings > end) { return 0; } //same rule as the interpreter's blocks
+	JitRegisters r;
+	r.A = cpu.A;
+	r.X = cpu.X;
+	r.Y = cpu.Y;
+	r.SP = cpu.SP;
+	r.C = cpu.C;
+	r.Z_result = cpu.Z_result;
+	r.N_result = cpu.N_result;
+	r.V = cpu.V;
+	r.extra_cycles = 0;
+	t.code(&r);
+	cpu.A = r.A;
+	cpu.X = r.X;
+	cpu.Y = r.Y;
+	cpu.SP = r.SP;
+	cpu.C = r.C;
+	cpu.Z_result = r.Z_result;
+	cpu.N_result = r.N_result;
+	cpu.V = r.V;
+	cpu.PC = cpu.PC + t.bytes;
+	mem.cycles = mem.cycles + t.cycles + r.extra_cycles;
+	native_runs++;
+	return 1;
+}
+
+static bool add_dependency(const MemIO& mem, int page, JitDependency* list, int& count, int limit) {
+	for (int i = 0; i < count; i++) {
+		if (list[i].page == page) { return 1; }
+	}
+	if (count >= limit) { return 0; }
+	list[count].page = page;
+	list[count].read = mem.read_page[page];
+	list[count].write = mem.write_page[page];
+	count = count + 1;
+	return 1;
+}
+
+static bool resolve_operand(const MemIO& mem, const OpInfo& op, unsigned short operand, bool reads, bool writes, JitOperand& out, JitDependency* list, int& count, int limit) {
+	int base, span;
+	switch (op.mode) {
+	case AddrMode::ZP: base = operand & 0xFF; span = 1; out.index = 0; break;
+	case AddrMode::ABS: base = operand & MemIO::ADDRESS_MASK; span = 1; out.index = 0; break;
+	case AddrMode::ABSX: base = operand & MemIO::ADDRESS_MASK; span = 0x100; out.index = REG_X; break;
+	case AddrMode::ABSY: base = operand & MemIO::ADDRESS_MASK; span = 0x100; out.index = REG_Y; break;
+	default: return 0;
+	}
+	if (base + span - 1 > MemIO::ADDRESS_MASK) { return 0; } //the index would wrap around the bus
+	int first = base >> MemIO::PAGE_BITS;
+	int last = (base + span - 1) >> MemIO::PAGE_BITS;
+	const unsigned char* read = mem.read_page[first];
+	unsigned char* write = mem.write_page[first];
+	for (int page = first; page <= last; page++) { //every index must land in one contiguous host block
+		MemIO::Device device = mem.page_device[page];
+		int step = (page - first) * MemIO::PAGE_SIZE;
+		if (reads && (((device != MemIO::DEV_MEMORY) && (device != MemIO::DEV_ROM)) || (read == NULL) || (mem.read_page[page] != read + step))) { return 0; }
+		if (writes && ((device != MemIO::DEV_MEMORY) || (write == NULL) || (mem.write_page[page] != write + step))) { return 0; }
+	}
+	if (reads && writes && (read != write)) { return 0; } //read-modify-write needs one byte, not separate ports
+	int saved = count;
+	for (int page = first; page <= last; page++) {
+		if (!add_dependency(mem, page, list, count, limit)) { count = saved; return 0; }
+	}
+	out.pointer = (writes ? write : (unsigned char*)read) + (base & MemIO::PAGE_MASK);
+	return 1;
+}
+
+const JitCache::Translation* JitCache::translate(const MemIO& mem, unsigned short address) {
+#ifndef JIT_X64
+	(void)mem;
+	(void)address;
+	return NULL;
+#else
+	Translation t;
+	t.dependency_count = 0;
+	t.bytes = 0;
+	t.cycles = 0;
+	t.crossings = 0;
+	t.count = 0;
+	static const int CODE_MAX = 64 * MAX_OPS + 128;
+	unsigned char buffer[CODE_MAX];
+	Emitter e(buffer, CODE_MAX);
+	e.push(RBX); e.push(R12); e.push(R13); e.push(R14); e.push(R15);
+	e.mov_rbx_argument();
+	e.movzx_state(REG_A, STATE_A);
+	e.movzx_state(REG_X, STATE_X);
+	e.movzx_state(REG_Y, STATE_Y);
+	e.movzx_state(REG_C, STATE_C);
+	e.movzx_state(REG_V, STATE_V);
+	e.zero(R15);
+	bool nz_pending = 0; //r8 holds the last N/Z result, still to be written back
+	while (t.count < MAX_OPS) {
+		int opcode_page = address >> MemIO::PAGE_BITS;
+		if (mem.page_device[opcode_page] != MemIO::DEV_ROM) { break; }
+		const OpInfo& op = Processor::op_table[mem.read_page[opcode_page][address & MemIO::PAGE_MASK]];
+		int end_page = (address + op.bytes - 1) >> MemIO::PAGE_BITS;
+		if ((end_page >= MemIO::PAGE_COUNT) || (mem.page_device[end_page] != MemIO::DEV_ROM)) { break; }
+		unsigned short operand = 0;
+		for (int i = op.bytes - 1; i > 0; i--) {
+			unsigned short at = address + i;
+			operand = (operand << 8) | mem.read_page[at >> MemIO::PAGE_BITS][at & MemIO::PAGE_MASK];
+		}
+		const JitOp* j = find_jit_op(op.mnemonic);
+		if (j == NULL) { break; }
+		int saved_dependencies = t.dependency_count;
+		int saved_size = e.size;
+		if (!add_dependency(mem, opcode_page, t.dependencies, t.dependency_count, MAX_DEPENDENCIES) || !add_dependency(mem, end_page, t.dependencies, t.dependency_count, MAX_DEPENDENCIES)) { t.dependency_count = saved_dependencies; break; }
+		bool immediate = (op.mode == AddrMode::IMM);
+		bool implied = (op.mode == AddrMode::IMP) || (op.mode == AddrMode::ACC);
+		bool reads = (j->kind == K_LOAD) || (j->kind == K_ALU) || (j->kind == K_COMPARE) || (j->kind == K_ADC) || (j->kind == K_SBC) || (j->kind == K_BIT) || (j->kind == K_STEP) || (j->kind == K_SHIFT);
+		bool writes = (j->kind == K_STORE) || (j->kind == K_STEP) || (j->kind == K_SHIFT);
+		JitOperand m;
+		m.pointer = NULL;
+		m.index = 0;
+		if (!implied && !immediate && !resolve_operand(mem, op, operand, reads, writes, m, t.dependencies, t.dependency_count, MAX_DEPENDENCIES)) {
+			t.dependency_count = saved_dependencies;
+			break;
+		}
+		bool penalty = (m.index != 0) && !writes; //indexed reads only, stores and read-modify-write always take the long path
+		if (penalty) { //r15 += carry out of the low address byte, before anything below can change the index
+			e.alu_reg_imm(ALU_CMP, m.index, 0xFF - ((operand & MemIO::ADDRESS_MASK) & 0xFF));
+			e.setcc_reg(COND_A, RAX);
+			e.movzx_reg(RAX, RAX);
+			e.add_r15_rax();
+		}
+		if (m.pointer != NULL) { e.mov_rdx_pointer(m.pointer); }
+		bool supported = 1;
+		switch (j->kind) {
+		case K_LOAD:
+			if (immediate) { e.mov_reg_imm(j->reg, operand); } else { e.mov_reg_mem(j->reg, m.index); }
+			e.mov_reg_reg(REG_NZ, j->reg);
+			nz_pending = 1;
+			break;
+		case K_STORE:
+			e.mov_mem_reg(m.index, j->reg);
+			break;
+		case K_ALU:
+			if (immediate) { e.alu_reg_imm((HostAlu)j->arg, REG_A, operand); } else { e.alu_reg_mem((HostAlu)j->arg, REG_A, m.index); }
+			e.mov_reg_reg(REG_NZ, REG_A);
+			nz_pending = 1;
+			break;
+		case K_COMPARE: //N and Z from reg - M, C when nothing was borrowed
+			e.mov_reg_reg(REG_NZ, j->reg);
+			if (immediate) { e.alu_reg_imm(ALU_SUB, REG_NZ, operand); } else { e.alu_reg_mem(ALU_SUB, REG_NZ, m.index); }
+			e.setcc_reg(COND_NC, REG_C);
+			nz_pending = 1;
+			break;
+		case K_ADC: case K_SBC: //binary only, decimal mode never enters native code
+			e.bt_carry();
+			if (j->kind == K_SBC) { e.cmc(); } //the 6502 carry is the inverted borrow
+			if (immediate) { e.alu_reg_imm((j->kind == K_ADC) ? ALU_ADC : ALU_SBB, REG_A, operand); }
+			else { e.alu_reg_mem((j->kind == K_ADC) ? ALU_ADC : ALU_SBB, REG_A, m.index); }
+			e.setcc_reg((j->kind == K_ADC) ? COND_C : COND_NC, REG_C);
+			e.setcc_reg(COND_O, REG_V);
+			e.mov_reg_reg(REG_NZ, REG_A);
+			nz_pending = 1;
+			break;
+		case K_BIT: //Z from A & M, N and V straight from bits 7 and 6 of M
+			if (m.index != 0) { supported = 0; break; }
+			e.mov_reg_mem(RAX, 0);
+			e.mov_state_reg(STATE_N_RESULT, RAX);
+			e.mov_reg_reg(RCX, RAX);
+			e.alu_reg_reg(ALU_AND, RCX, REG_A);
+			e.mov_state_reg(STATE_Z_RESULT, RCX);
+			e.shift_reg(SHIFT_SHL, RAX);
+			e.shift_reg(SHIFT_SHL, RAX);
+			e.setcc_reg(COND_C, REG_V);
+			nz_pending = 0; //BIT's own bytes are final, r8 is stale
+			break;
+		case K_STEP:
+			if (implied) {
+				e.inc_reg(j->reg, j->arg);
+				e.mov_reg_reg(REG_NZ, j->reg);
+			}
+			else {
+				e.inc_mem(m.index, j->arg);
+				e.mov_reg_mem(REG_NZ, m.index);
+			}
+			nz_pending = 1;
+			break;
+		case K_SHIFT:
+			if ((j->arg == SHIFT_RCL) || (j->arg == SHIFT_RCR)) { e.bt_carry(); } //rotates go through the guest carry
+			if (implied) {
+				e.shift_reg((HostShift)j->arg, REG_A);
+				e.setcc_reg(COND_C, REG_C);
+				e.mov_reg_reg(REG_NZ, REG_A);
+			}
+			else {
+				e.shift_mem((HostShift)j->arg, m.index);
+				e.setcc_reg(COND_C, REG_C);
+				e.mov_reg_mem(REG_NZ, m.index);
+			}
+			nz_pending = 1;
+			break;
+		case K_TRANSFER:
+			e.mov_reg_reg(j->reg, j->arg);
+			e.mov_reg_reg(REG_NZ, j->reg);
+			nz_pending = 1;
+			break;
+		case K_TSX:
+			e.mov_reg_state(REG_X, STATE_SP);
+			e.mov_reg_reg(REG_NZ, REG_X);
+			nz_pending = 1;
+			break;
+		case K_TXS:
+			e.mov_state_reg(STATE_SP, REG_X);
+			break;
+		case K_CLC: e.zero(REG_C); break;
+		case K_SEC: e.mov_reg_imm(REG_C, 1); break;
+		case K_CLV: e.zero(REG_V); break;
+		case K_NOP: break;
+		default: supported = 0;
+		}
+		if (!supported || (e.size > CODE_MAX - 64)) { //keep room for the epilogue
+			e.size = saved_size;
+			t.dependency_count = saved_dependencies;
+			break;
+		}
+		t.bytes = t.bytes + op.bytes;
+		t.cycles = t.cycles + op.cycles;
+		t.crossings = t.crossings + penalty;
+		t.count = t.count + 1;
+		address = address + op.bytes;
+		if (!(address & 0x1000)) { break; } //ran off the top of cartridge space
+	}
+	if (t.count == 0) { return NULL; }
+	if (nz_pending) {
+		e.mov_state_reg(STATE_Z_RESULT, REG_NZ);
+		e.mov_state_reg(STATE_N_RESULT, REG_NZ);
+	}
+	e.mov_state_reg(STATE_A, REG_A);
+	e.mov_state_reg(STATE_X, REG_X);
+	e.mov_state_reg(STATE_Y, REG_Y);
+	e.mov_state_reg(STATE_C, REG_C);
+	e.mov_state_reg(STATE_V, REG_V);
+	e.mov_state_r15(STATE_EXTRA);
+	e.pop(R15); e.pop(R14); e.pop(R13); e.pop(R12); e.pop(RBX);
+	e.ret();
+	int header = (sizeof(Translation) + 15) & ~15;
+	int total = (header + e.size + 15) & ~15;
+	if (arena_used + total > ARENA_BYTES) { flush(); } //nothing points into the arena while translating
+	make_writable(1);
+	Translation* stored = (Translation*)(arena + arena_used);
+	memcpy(arena + arena_used + header, buffer, e.size);
+	t.code = (NativeBlock)(arena + arena_used + header);
+	*stored = t;
+	make_writable(0);
+	arena_used = arena_used + total;
+	translations++;
+	return stored;
+#endif
+}
@@ -0,0 +1,84 @@
+#pragma once
+#define JIT_H
+
+#include "memory.h"
+
+// Native tier for hot ROM code, x86-64 hosts only (JIT_X64 is defined on those; elsewhere set_jit has no effect).
+// Once a cartridge address has started a run JIT_THRESHOLD times, the longest straight-line prefix of plain
+// instructions found there is translated to x86-64 and kept in an executable arena. A, X and Y live in host
+// registers for the whole block, N and Z are kept as the last result byte and only written back on exit, and memory
+// operands are host pointers resolved at translation time. A prefix stops before anything the interpreter has to see:
+// device pages (TIA, RIOT, hotspots), the stack, run-time addresses, control flow, decimal mode and interrupt flags.
+// Those instructions run interpreted with the exact clock, so the native code never calls out.
+// Only cartridge ROM is translated, code in RAM always goes through the interpreter. A translation stays valid as long
+// as every page it uses still maps the same bytes, so switching back to a bank reuses its code. A new cartridge may be
+// allocated where the old one was, so inserting one flushes everything (MemIO::cache_epoch).
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X64
+#endif
+
+class Processor;
+
+struct JitRegisters { //guest state handed to native code, offsets are baked into the generated instructions
+	unsigned char A; //+0
+	unsigned char X; //+1
+	unsigned char Y; //+2
+	unsigned char SP; //+3
+	unsigned char C; //+4, 0/1
+	unsigned char Z_result; //+5, lazy as in Processor
+	unsigned char N_result; //+6
+	unsigned char V; //+7, 0/1
+	unsigned long long extra_cycles; //+8, page crossings taken
+};
+
+struct JitDependency { //a page a translation relies on, valid while the bus still maps it the same way
+	unsigned short page;
+	const unsigned char* read;
+	unsigned char* write;
+};
+
+typedef void (*NativeBlock)(JitRegisters* registers);
+
+class JitCache {
+public:
+	JitCache();
+	~JitCache();
+	JitCache(const JitCache&) = delete;
+	JitCache& operator=(const JitCache&) = delete;
+
+	bool run(Processor& cpu, MemIO& mem, unsigned long long end); //native code at PC if there is some and its worst case ends by end, FALSE if nothing ran
+	void flush(); //drop every translation
+
+	static const int JIT_THRESHOLD = 64; //runs from one address before it is translated
+	static const int ARENA_BYTES = 1 << 18; //executable memory, flushed whole when full
+	static const int MAX_DEPENDENCIES = 12; //pages a translation may touch, an indexed operand alone spans up to five
+	static const int MAX_OPS = 32;
+
+	unsigned long long translations; //statistics
+	unsigned long long native_runs;
+
+private:
+	struct Translation { //header in the arena, code follows
+		NativeBlock code;
+		JitDependency dependencies[MAX_DEPENDENCIES];
+		int dependency_count;
+		unsigned short bytes; //guest bytes covered, PC moves by this much
+		unsigned short cycles; //summed base cycles
+		unsigned char crossings; //instructions that may add a page crossing cycle
+		unsigned char count; //guest instructions covered
+	};
+	struct Entry { //one per address of $1000-$1FFF
+		const Translation* translation; //NULL: not translated
+		unsigned int generation; //MemIO::map_generation the translation (or failed attempt) was last checked at
+		unsigned short heat; //runs started here, stops counting at JIT_THRESHOLD
+	};
+	Entry* entries;
+	unsigned char* arena;
+	int arena_used;
+
+	bool remapped(const MemIO& mem, const Translation& t, unsigned int generation) const; //a page it depends on was remapped since generation
+	bool still_mapped(const MemIO& mem, const Translation& t) const;
+	const Translation* translate(const MemIO& mem, unsigned short address); //NULL if not even one instruction qualifies
+	void make_writable(bool writable);
+};
@@ -1,45 +1,51 @@
 #include <iostream>
-#include <fstream>
 
 #include "loader.h"
 #include "memory.h"
+#include "cartridge.h"
+#include "romdb.h"
+#include "romimage.h"
 
-int Loader::load_from_file(std::string filename, unsigned short address_start, MemIO mem) {// filename is the directory of the binary file containing the cartridge data, address_start is the first location in memory to load from
-	//file is read
-	std::ifstream file;
-	file.open(filename, std::ios::binary); 
-
-	if (!file.is_open()) { 
-		std::cerr << "Error opening file" << std::endl;
-		return -1; } //file opening error
-	
-	//determining size of file
-	file.seekg(0, std::ios::end); //placing seek at end of file to get total size
-	int fileSize = file.tellg();  //get current seeker position (end) == find file size
-	file.seekg(0, std::ios::beg); //restart at file beginning to read
-
-	char* buffer = new char[fileSize]; // creating a buffer to store contents
-	file.read(buffer, fileSize); //dumping file contents into buffer, will later be loaded into memory/cartridge space
-	int bytesRead = file.gcount(); // total size of file read
-	
-	file.close(); //closing file 
-	
+int Loader::load_from_file(std::string filename, unsigned short address_start, MemIO& mem) {// filename is the directory of the binary file containing the cartridge data, address_start is the first location in memory to load from
+	RomImage* image = RomImage::map_file(filename); //read-only mapping, no intermediate buffer
+	if (image == NULL) { return -1; } //file opening error
+	int bytesRead = image->size;
 
 	//checking to see if rom size is coherent with available memory
-	int available_space = mem.array_size - address_start; // address prior to start unavailable for load
+	int available_space = (MemIO::ADDRESS_MASK + 1) - (address_start & MemIO::ADDRESS_MASK); // address prior to start unavailable for load, 13-bit bus
 	if (bytesRead > available_space) {// ROM too large
 		std::cerr << "ROM size error ! Not enough space available !" << std::endl;
+		delete image;
 		return -2;//error
 	}
 
 	last_size_loaded = bytesRead;
 	//printf("%d", last_size_loaded);
+	if ((address_start & MemIO::ADDRESS_MASK) == 0x1000 && (bytesRead == 0x800 || bytesRead == 0x1000)) { //a whole 2K/4K cart: attach the mapping itself, nothing is copied
+		mem.insert_cartridge(Cartridge::create(image, Cartridge::default_scheme(bytesRead)));
+		return 0;
+	}
 	//loading into memory
 	for (int i = 0; i < (bytesRead); i++) {//iterating across the entire file
-		mem.write((i + address_start), buffer[i]); //loading bytes into RAM one by one, from starting address
+		mem.poke((i + address_start), image->data[i]); //loading bytes one by one from starting address, ROM pages ignore bus writes
 	}
 	 //keeping track of loaded contents 
-	delete[] buffer; //deleting loading buffer
+	delete image; //unmapping
 	return 0;
 
-}
\ No newline at end of file
+}
+
+int Loader::load_cartridge(std::string filename, std::string scheme, MemIO& mem) {
+	RomImage* image = RomImage::map_file(filename);
+	if (image == NULL) { return -1; } //file opening error
+	int bytesRead = image->size;
+
+	last_rom = identify_rom(image->data, bytesRead); //database first, then heuristics
+	if (scheme == "") { scheme = last_rom.scheme; }
+	Cartridge* cart = Cartridge::create(image, scheme); //the bus pages point straight into the mapping
+	if (cart == NULL) { return -2; } //size does not fit any known scheme
+
+	last_size_loaded = bytesRead;
+	mem.insert_cartridge(cart);
+	return 0;
+}
@@ -4,12 +4,15 @@
 #define LOADER_H
 
 #include "memory.h"
+#include "romdb.h"
 
 
 class Loader {
 public:
 	int last_size_loaded; //keeps track of the size of the last file that was loaded
-	int load_from_file(std::string filename, unsigned short address_start, MemIO mem);
+	int load_from_file(std::string filename, unsigned short address_start, MemIO& mem); //raw image at address_start, 2K/4K carts only. A whole cart at $1000 is mapped in place, anything else is poked
+	RomInfo last_rom; //what load_cartridge found out about the last image (scheme, TV standard, controllers)
+	int load_cartridge(std::string filename, std::string scheme, MemIO& mem); //image as a bank-switched Cartridge, scheme "" uses the detected one
 
 };
 
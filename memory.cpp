@@ -4,37 +4,202 @@
 #include <sstream>
 #include <string>
 
+#include <cstring>
+
 #include "memory.h"
+#include "cartridge.h"
 #include "cpu.h"
 
+struct PlayfieldTables { //bit expansion of each PF register into playfield cells, one bit per 4-pixel cell
+	unsigned int left[3][256]; //cells 0-19, left half of the screen (also the right half when not reflected)
+	unsigned int reflected[3][256]; //same cells mirrored, for the right half when CTRLPF reflects
+	PlayfieldTables() {
+		for (int v = 0; v < 256; v++) {
+			left[0][v] = 0;
+			left[1][v] = 0;
+			left[2][v] = 0;
+			for (int i = 0; i < 4; i++) { if (v & (0x10 << i)) { left[0][v] |= 1u << i; } } //PF0 bits 4-7, drawn 4 to 7
+			for (int i = 0; i < 8; i++) { if (v & (0x80 >> i)) { left[1][v] |= 1u << (4 + i); } } //PF1 bits 7-0
+			for (int i = 0; i < 8; i++) { if (v & (0x01 << i)) { left[2][v] |= 1u << (12 + i); } } //PF2 bits 0-7
+			for (int reg = 0; reg < 3; reg++) {
+				reflected[reg][v] = 0;
+				for (int cell = 0; cell < 20; cell++) {
+					if (left[reg][v] & (1u << cell)) { reflected[reg][v] |= 1u << (19 - cell); }
+				}
+			}
+		}
+	}
+};
+static const PlayfieldTables pf_tables; //built once at startup, shared by every MemIO
+
 
-MemIO::MemIO(int ram_size, std::string colormap_file, int horizontal_res, int vertical_res) {
+static unsigned char MemIO::* const tia_registers[] = { //every TIA register byte, in TiaState order
+	&MemIO::VSYNC, &MemIO::VBLANK, &MemIO::WSYNC, &MemIO::RSYNC, &MemIO::NUSIZ0, &MemIO::NUSIZ1, &MemIO::COLUP0, &MemIO::COLUP1,
+	&MemIO::COLUPF, &MemIO::COLUBK, &MemIO::CTRLPF, &MemIO::REFP0, &MemIO::REFP1, &MemIO::PF0, &MemIO::PF1, &MemIO::PF2,
+	&MemIO::RESP0, &MemIO::RESP1, &MemIO::RESM0, &MemIO::RESM1, &MemIO::RESBL, &MemIO::GRP0, &MemIO::GRP1, &MemIO::ENAM0,
+	&MemIO::ENAM1, &MemIO::ENABL, &MemIO::HMP0, &MemIO::HMP1, &MemIO::HMM0, &MemIO::HMM1, &MemIO::HMBL, &MemIO::VDELP0,
+	&MemIO::VDELP1, &MemIO::VDELBL, &MemIO::RESMP0, &MemIO::RESMP1, &MemIO::HMOVE, &MemIO::HMCLR, &MemIO::CXCLR,
+	&MemIO::CXM0P, &MemIO::CXM1P, &MemIO::CXP0FB, &MemIO::CXP1FB, &MemIO::CXM0FB, &MemIO::CXM1FB, &MemIO::CXBLPF, &MemIO::CXPPMM,
+	&MemIO::INPT0, &MemIO::INPT1, &MemIO::INPT2, &MemIO::INPT3, &MemIO::INPT4, &MemIO::INPT5
+};
+static_assert(sizeof(tia_registers) / sizeof(tia_registers[0]) == TIA_REGISTER_COUNT, "TiaState.registers does not match the register list");
+
+MemIO::MemIO(int ram_size, std::string colormap_file, int horizontal_res, int vertical_res) : frame(horizontal_res, vertical_res) {
 	array_size = ram_size; //number of elements in array	
+	if (array_size < ADDRESS_MASK + 1) { array_size = ADDRESS_MASK + 1; } //backs the whole 13-bit space
 	//initialising array representing memory
-	mem_array = new unsigned char[array_size];
+	mem_array = new unsigned char[array_size]();
+	cart = NULL;
+	map_generation = 1; //0 stays older than every page, caches start their entries there
+	cache_epoch = 0;
+	for (int i = 0; i < PAGE_COUNT; i++) { page_generation[i] = 1; }
+	map_pages();
+	cycles = 0;
+	//display, frame holds one row per scanline and one cell per color clock
+	this->horizontal_res = horizontal_res;
+	this->vertical_res = vertical_res;
+	load_colormap(colormap_file);
+	rendered_clock = 0;
+	frame_start_clock = 0;
+	pf_mask = 0;
+	pos_P0 = 0;
+	pos_P1 = 0;
+	pos_M0 = 0;
+	pos_M1 = 0;
+	pos_BL = 0;
+	masks_dirty = 1;
+	composite = select_compositor(); //SIMD kernel for this host
+	h_counter = 0;
+	v_counter = 0;
+	//TIA starts with every write register cleared
+	vsync = 0;
+	for (int i = 0; i < TIA_REGISTER_COUNT; i++) { this->*tia_registers[i] = 0; } //strobes are never stored by check_write
+	for (unsigned short address = 0x00; address <= 0x2C; address++) { check_write(address, 0); }
+	GRP0_old = 0; //the GRP writes above copied the registers before they were cleared
+	GRP1_old = 0;
+	ENABL_old = 0;
+	CXM0P = 0;
+	CXM1P = 0;
+	CXP0FB = 0;
+	CXP1FB = 0;
+	CXM0FB = 0;
+	CXM1FB = 0;
+	CXBLPF = 0;
+	CXPPMM = 0;
+	INPT0 = 0;
+	INPT1 = 0;
+	INPT2 = 0;
+	INPT3 = 0;
+	INPT4 = 0x80; //fire buttons read high when not pressed
+	INPT5 = 0x80;
+	cpu_waiting = 0; //clearing the WSYNC strobe above
+	frame_ready = 0;
+}
+// ####### bus #####
+
+void MemIO::map_pages() {
+	for (int page = 0; page < PAGE_COUNT; page++) {
+		unsigned short base = page << PAGE_BITS;
+		if (base & 0x1000) { //A12: cartridge
+			page_device[page] = DEV_ROM;
+			read_page[page] = mem_array + base;
+			write_page[page] = NULL; //ROM, writes are dropped
+		}
+		else if (!(base & 0x0080)) { //A7 low: TIA
+			page_device[page] = DEV_TIA;
+			read_page[page] = NULL;
+			write_page[page] = NULL;
+		}
+		else if (!(base & 0x0200)) { //A7 high, A9 low: RIOT RAM, 128 bytes mirrored at $80, $180, ...
+			page_device[page] = DEV_MEMORY;
+			read_page[page] = riot.ram + (base & 0x40);
+			write_page[page] = riot.ram + (base & 0x40);
+		}
+		else { //A7 and A9 high: RIOT timer and ports
+			page_device[page] = DEV_RIOT_IO;
+			read_page[page] = NULL;
+			write_page[page] = NULL;
+		}
+	}
+	remap(0, PAGE_COUNT);
 }
-unsigned char MemIO::read(unsigned short address) {
-	//is this an access to TIA registers?
-	unsigned char reg_tia = check_read(address);
-	unsigned char value;
-	if (is_reserved_TIA == 0) { //address not mapped to tia
-		value = mem_array[address];
+
+void MemIO::remap(int page, int count) {
+	map_generation = map_generation + 1;
+	if (map_generation == 0) { //wrapped, stamps from before would look older than entries cached since
+		map_generation = 1;
+		cache_epoch = cache_epoch + 1;
+		for (int i = 0; i < PAGE_COUNT; i++) { page_generation[i] = 1; }
 	}
-	else { //address is mapped to tia
-		value = reg_tia;
+	for (int i = 0; i < count; i++) {
+		page_generation[(page + i) & (PAGE_COUNT - 1)] = map_generation;
 	}
-	return value; //returning value to program
 }
 
-void MemIO::write(unsigned short address, unsigned char value) {
-	//writing to array
+MemIO::~MemIO() {
+	delete cart;
+	delete[] mem_array;
+	delete[] colormap;
+}
+
+void MemIO::insert_cartridge(Cartridge* cartridge) {
+	delete cart;
+	map_pages(); //forget the previous cartridge's mapping
+	cache_epoch = cache_epoch + 1; //the new ROM may sit where the old one was, same page pointers but other code
+	cart = cartridge;
+	cart->attach(*this);
+}
+
+unsigned char MemIO::read_device(unsigned short address) {
+	is_reserved_RIOT = (page_device[address >> PAGE_BITS] == DEV_RIOT_IO);
+	switch (page_device[address >> PAGE_BITS]) {
+	case DEV_TIA:
+		return check_read(0x30 | (address & 0x0F)); //A0-A3 select the read register, every TIA page mirrors $30-$3F
+	case DEV_RIOT_IO:
+		return riot.read(address, cycles);
+	case DEV_CART:
+		return cart->read(address);
+	default:
+		return mem_array[address];
+	}
+}
+
+void MemIO::write_device(unsigned short address, unsigned char value) {
+	is_reserved_RIOT = (page_device[address >> PAGE_BITS] == DEV_RIOT_IO);
+	switch (page_device[address >> PAGE_BITS]) {
+	case DEV_TIA:
+		check_write(address & 0x3F, value); //A0-A5 select the write register
+		if ((cart != NULL) && cart->watches_tia) { cart->tia_write(address, value); }
+		break;
+	case DEV_RIOT_IO:
+		riot.write(address, value, cycles);
+		break;
+	case DEV_CART:
+		cart->write(address, value);
+		break;
+	default: //ROM
+		break;
+	}
+}
+
+void MemIO::poke(unsigned short address, unsigned char value) {
+	address = address & ADDRESS_MASK;
+	if (page_device[address >> PAGE_BITS] == DEV_MEMORY) { //RAM mirrors all land on the same bytes
+		write_page[address >> PAGE_BITS][address & PAGE_MASK] = value;
+		return;
+	}
 	mem_array[address] = value;
+	remap(address >> PAGE_BITS, 1); //may be code the CPU has already decoded
 }
 
 void MemIO::flush() {
 	for (int i = 0; i < array_size; i++) {
 		mem_array[i] = 0;
 	}
+	remap(0, PAGE_COUNT);
+	for (int i = 0; i < 128; i++) {
+		riot.ram[i] = 0;
+	}
 }
 
 
@@ -85,9 +250,16 @@ unsigned int MemIO::get_RGB(unsigned char color) {
 	return hit;
 }
 
+void MemIO::enable_rgba() {
+	unsigned int palette[256];
+	for (int color = 0; color < 256; color++) { palette[color] = get_RGB(color); }
+	frame.enable_rgba(palette);
+}
+
 unsigned char MemIO::check_read(unsigned short address) {
 	if ((address >= 0x30) && (address <= 0x3D)) { //address is in correct range for TIA read
 		is_reserved_TIA = 1;
+		tia_sync(); //collision latches must reflect every pixel drawn so far
 		//checking all address
 		switch (address) {
 		case 0x30:
@@ -147,19 +319,404 @@ unsigned char MemIO::check_read(unsigned short address) {
 void MemIO::check_write(unsigned short address, unsigned char val) {
 	if ((address >= 0x00) and (address <= 0x2C)) { //address in range for TIA write/strobe registers
 		is_reserved_TIA = 1; //indicates that address is mapped to TIA
+		tia_sync(); //pixels up to now are drawn with the registers as they were
 		switch (address) {
 		case 0x00: //VSYNC reg, bit 1 sets vertical sync
 			fct_VSYNC(val);
+			break;
+		case 0x01:
+			VBLANK = val;
+			break;
+		case 0x02: //WSYNC strobe, TIA pulls RDY low until the end of the scanline
+			cpu_waiting = 1;
+			break;
+		case 0x03:
+			RSYNC = val;
+			break;
+		case 0x04:
+			NUSIZ0 = val;
+			masks_dirty = 1;
+			break;
+		case 0x05:
+			NUSIZ1 = val;
+			masks_dirty = 1;
+			break;
+		case 0x06:
+			COLUP0 = val;
+			break;
+		case 0x07:
+			COLUP1 = val;
+			break;
+		case 0x08:
+			COLUPF = val;
+			break;
+		case 0x09:
+			COLUBK = val;
+			break;
+		case 0x0A:
+			CTRLPF = val;
+			update_playfield();
+			break;
+		case 0x0B:
+			REFP0 = val;
+			masks_dirty = 1;
+			break;
+		case 0x0C:
+			REFP1 = val;
+			masks_dirty = 1;
+			break;
+		case 0x0D:
+			PF0 = val;
+			update_playfield();
+			break;
+		case 0x0E:
+			PF1 = val;
+			update_playfield();
+			break;
+		case 0x0F:
+			PF2 = val;
+			update_playfield();
+			break;
+		case 0x10:
+			RESP0 = val;
+			pos_P0 = reset_position(1); //strobe, player 0 starts at the current beam position
+			masks_dirty = 1;
+			break;
+		case 0x11:
+			RESP1 = val;
+			pos_P1 = reset_position(1);
+			masks_dirty = 1;
+			break;
+		case 0x12:
+			RESM0 = val;
+			pos_M0 = reset_position(0);
+			masks_dirty = 1;
+			break;
+		case 0x13:
+			RESM1 = val;
+			pos_M1 = reset_position(0);
+			masks_dirty = 1;
+			break;
+		case 0x14:
+			RESBL = val;
+			pos_BL = reset_position(0);
+			masks_dirty = 1;
+			break;
+		case 0x1B:
+			GRP0 = val;
+			GRP1_old = GRP1; //writing GRP0 moves GRP1 into its vertical delay copy
+			masks_dirty = 1;
+			break;
+		case 0x1C:
+			GRP1 = val;
+			GRP0_old = GRP0; //writing GRP1 moves GRP0 and ENABL into their vertical delay copies
+			ENABL_old = ENABL;
+			masks_dirty = 1;
+			break;
+		case 0x1D:
+			ENAM0 = val;
+			masks_dirty = 1;
+			break;
+		case 0x1E:
+			ENAM1 = val;
+			masks_dirty = 1;
+			break;
+		case 0x1F:
+			ENABL = val;
+			masks_dirty = 1;
+			break;
+		case 0x20:
+			HMP0 = val;
+			break;
+		case 0x21:
+			HMP1 = val;
+			break;
+		case 0x22:
+			HMM0 = val;
+			break;
+		case 0x23:
+			HMM1 = val;
+			break;
+		case 0x24:
+			HMBL = val;
+			break;
+		case 0x25:
+			VDELP0 = val;
+			masks_dirty = 1;
+			break;
+		case 0x26:
+			VDELP1 = val;
+			masks_dirty = 1;
+			break;
+		case 0x27:
+			VDELBL = val;
+			masks_dirty = 1;
+			break;
+		case 0x28:
+			RESMP0 = val;
+			if (RESMP0 & 0x02) { pos_M0 = (pos_P0 + missile_center(NUSIZ0)) % VISIBLE_PIXELS; } //missile parked on the player
+			masks_dirty = 1;
+			break;
+		case 0x29:
+			RESMP1 = val;
+			if (RESMP1 & 0x02) { pos_M1 = (pos_P1 + missile_center(NUSIZ1)) % VISIBLE_PIXELS; }
+			masks_dirty = 1;
+			break;
+		case 0x2A:
+			HMOVE = val;
+			fct_HMOVE();
+			break;
+		case 0x2B:
+			HMCLR = val;
+			HMP0 = 0; //strobe, clears every motion register
+			HMP1 = 0;
+			HMM0 = 0;
+			HMM1 = 0;
+			HMBL = 0;
+			break;
+		case 0x2C:
+			CXCLR = val;
+			CXM0P = 0; //strobe, clears every collision latch
+			CXM1P = 0;
+			CXP0FB = 0;
+			CXP1FB = 0;
+			CXM0FB = 0;
+			CXM1FB = 0;
+			CXBLPF = 0;
+			CXPPMM = 0;
+			break;
+		default: //audio registers, TBD
+			break;
+		}
+	}
+	else { //not part of TIA write register space
+		is_reserved_TIA = 0;
+	}
+}
+
+void MemIO::fct_VSYNC(unsigned char val) {
+	bool vsync_set = val & 0x02; //get second bits of "val"
+	if (vsync_set && !vsync) { //start of vertical sync, the previous frame is complete
+		frame_ready = 1;
+		frame.present((rendered_clock - frame_start_clock) / horizontal_res + 1); //hand the frame over, lines up to the VSYNC one were drawn
+		frame_start_clock = rendered_clock - (rendered_clock - frame_start_clock) % horizontal_res; //new frame starts on this scanline
+		memset(frame.row(0), 0, rendered_clock - frame_start_clock); //part of the VSYNC line already drawn went to the previous frame
+	}
+	vsync = vsync_set;
+	VSYNC = val; //saving to register for future reference
+
+}
+
+// ####### lazy rendering #####
+// The TIA is not ticked per color clock. Pixels are drawn in spans, up to the current beam position, only when a register
+// is about to change (or a collision latch is read): everything since the last update was drawn with the same registers.
+
+void MemIO::tia_sync() {
+	render_to(cycles * 3); //3 color clocks per CPU cycle
+}
+
+void MemIO::render_to(unsigned long long clock) {
+	while (rendered_clock < clock) {
+		unsigned long long beam = rendered_clock - frame_start_clock; //color clocks since the frame started
+		int line = beam / horizontal_res;
+		int x0 = beam % horizontal_res;
+		int x1 = horizontal_res; //span never crosses a scanline
+		if (clock - rendered_clock < (unsigned long long)(x1 - x0)) { x1 = x0 + (clock - rendered_clock); }
+		if (line < vertical_res) { render_span(line, x0, x1); } //lines past the buffer (no VSYNC yet) are dropped
+		rendered_clock = rendered_clock + (x1 - x0);
+		v_counter = line;
+		h_counter = x1;
+	}
+}
+
+void MemIO::render_span(int line, int x0, int x1) {
+	unsigned char* row = frame.row(line);
+	int hblank_end = horizontal_res - 160; //first 68 color clocks of a line are horizontal blank
+	if (x0 < hblank_end) {
+		int blank_end = (x1 < hblank_end) ? x1 : hblank_end;
+		memset(row + x0, 0, blank_end - x0);
+		x0 = blank_end;
+	}
+	if (x0 >= x1) { return; }
+	if (masks_dirty) { build_masks(); }
+	if (objects_visible) { latch_collisions(collide_span(masks, x0 - hblank_end, x1 - hblank_end)); } //collisions still register during VBLANK
+	if (VBLANK & 0x02) { //beam turned off
+		memset(row + x0, 0, x1 - x0);
+		return;
+	}
+	if (!objects_visible) { //playfield and background only, run fill is enough
+		render_playfield(row + hblank_end, x0 - hblank_end, x1 - hblank_end);
+		return;
+	}
+	CompositeColors colors;
+	colors.bk = COLUBK;
+	colors.pf_left = (CTRLPF & 0x02) ? COLUP0 : COLUPF; //score mode, playfield takes the player colors
+	colors.pf_right = (CTRLPF & 0x02) ? COLUP1 : COLUPF;
+	colors.bl = COLUPF;
+	colors.p0 = COLUP0;
+	colors.p1 = COLUP1;
+	colors.pf_priority = CTRLPF & 0x04;
+	composite(masks, colors, x0 - hblank_end, x1 - hblank_end, line_buffer); //span rounded to the kernel's width, then keep the span
+	memcpy(row + x0, line_buffer + (x0 - hblank_end), x1 - x0);
+}
+
+void MemIO::latch_collisions(unsigned short pairs) { //OR a collide_span result into CXM0P-CXPPMM
+	if (pairs == 0) { return; }
+	unsigned char* latches[8] = { &CXM0P, &CXM1P, &CXP0FB, &CXP1FB, &CXM0FB, &CXM1FB, &CXBLPF, &CXPPMM };
+	for (int n = 0; n < 8; n++) {
+		*latches[n] |= (((pairs >> (2 * n)) & 1) << 7) | (((pairs >> (2 * n + 1)) & 1) << 6);
+	}
+}
+
+void MemIO::update_playfield() { //rebuild the 40-cell playfield mask, only done when PF0-2 or CTRLPF change
+	unsigned int left = pf_tables.left[0][PF0] | pf_tables.left[1][PF1] | pf_tables.left[2][PF2];
+	unsigned int right = left;
+	if (CTRLPF & 0x01) { //reflected playfield
+		right = pf_tables.reflected[0][PF0] | pf_tables.reflected[1][PF1] | pf_tables.reflected[2][PF2];
+	}
+	pf_mask = left | ((unsigned long long)right << 20);
+	masks_dirty = 1;
+}
 
+// ####### objects #####
 
+static const int copy_count[8] = { 1, 2, 2, 3, 2, 1, 3, 1 }; //NUSIZ bits 0-2: number of copies of player/missile
+static const int copy_offset[8][3] = { {0}, {0, 16}, {0, 32}, {0, 16, 32}, {0, 64}, {0}, {0, 32, 64}, {0} }; //pixel offset of each copy
+static const int player_scale[8] = { 1, 1, 1, 1, 1, 2, 1, 4 }; //double and quad size players
+
+static void draw_span(unsigned char* mask, int pos, int width) { //sets width pixels from pos, wrapping around the line
+	for (int i = 0; i < width; i++) { mask[(pos + i) % VISIBLE_PIXELS] = 0xFF; }
+}
+
+static bool draw_player(unsigned char* mask, int pos, unsigned char graphics, bool reflect, unsigned char nusiz) {
+	if (graphics == 0) { return 0; }
+	int mode = nusiz & 0x07;
+	int scale = player_scale[mode];
+	for (int copy = 0; copy < copy_count[mode]; copy++) {
+		for (int bit = 0; bit < 8; bit++) {
+			bool on = reflect ? (graphics & (0x01 << bit)) : (graphics & (0x80 >> bit)); //bit 7 drawn first unless reflected
+			if (on) { draw_span(mask, pos + copy_offset[mode][copy] + bit * scale, scale); }
 		}
+	}
+	return 1;
+}
 
+static bool draw_missile(unsigned char* mask, int pos, bool enabled, unsigned char nusiz) {
+	if (!enabled) { return 0; }
+	int mode = nusiz & 0x07;
+	int width = 1 << ((nusiz >> 4) & 0x03); //NUSIZ bits 4-5
+	for (int copy = 0; copy < copy_count[mode]; copy++) {
+		draw_span(mask, pos + copy_offset[mode][copy], width);
 	}
+	return 1;
 }
 
-void MemIO::fct_VSYNC(unsigned char val) {
-	bool vsync_set = val & 0x02; //get second bits of "val"
+int MemIO::missile_center(unsigned char nusiz) { //offset from player position where RESMP parks the missile
+	int scale = player_scale[nusiz & 0x07];
+	return (scale == 1) ? 3 : ((scale == 2) ? 6 : 10);
+}
 
-	VSYNC = val; //saving to register for future reference
+unsigned char MemIO::reset_position(bool player) { //visible column an object lands on when its RESxx is strobed now
+	int x = (rendered_clock - frame_start_clock) % horizontal_res - (horizontal_res - VISIBLE_PIXELS); //beam position in visible pixels
+	if (x < 0) { return player ? 3 : 2; } //strobed during HBLANK
+	return (x + (player ? 5 : 4)) % VISIBLE_PIXELS; //objects start drawing a few clocks after the strobe
+}
+
+void MemIO::fct_HMOVE() { //move every object by its signed motion register (upper nibble, positive moves left)
+	pos_P0 = (pos_P0 - ((signed char)HMP0 >> 4) + VISIBLE_PIXELS) % VISIBLE_PIXELS;
+	pos_P1 = (pos_P1 - ((signed char)HMP1 >> 4) + VISIBLE_PIXELS) % VISIBLE_PIXELS;
+	pos_M0 = (pos_M0 - ((signed char)HMM0 >> 4) + VISIBLE_PIXELS) % VISIBLE_PIXELS;
+	pos_M1 = (pos_M1 - ((signed char)HMM1 >> 4) + VISIBLE_PIXELS) % VISIBLE_PIXELS;
+	pos_BL = (pos_BL - ((signed char)HMBL >> 4) + VISIBLE_PIXELS) % VISIBLE_PIXELS;
+	masks_dirty = 1;
+}
+
+void MemIO::build_masks() { //expand every object into its 160-pixel mask, only when one of their registers changed
+	for (int cell = 0; cell < 40; cell++) {
+		memset(masks.pf + cell * 4, ((pf_mask >> cell) & 1) ? 0xFF : 0x00, 4);
+	}
+	memset(masks.bl, 0, VISIBLE_PIXELS);
+	memset(masks.p0, 0, VISIBLE_PIXELS);
+	memset(masks.p1, 0, VISIBLE_PIXELS);
+	memset(masks.m0, 0, VISIBLE_PIXELS);
+	memset(masks.m1, 0, VISIBLE_PIXELS);
+	bool visible = 0;
+	visible |= draw_player(masks.p0, pos_P0, (VDELP0 & 0x01) ? GRP0_old : GRP0, REFP0 & 0x08, NUSIZ0);
+	visible |= draw_player(masks.p1, pos_P1, (VDELP1 & 0x01) ? GRP1_old : GRP1, REFP1 & 0x08, NUSIZ1);
+	visible |= draw_missile(masks.m0, pos_M0, (ENAM0 & 0x02) && !(RESMP0 & 0x02), NUSIZ0);
+	visible |= draw_missile(masks.m1, pos_M1, (ENAM1 & 0x02) && !(RESMP1 & 0x02), NUSIZ1);
+	bool ball = ((VDELBL & 0x01) ? ENABL_old : ENABL) & 0x02;
+	if (ball) { draw_span(masks.bl, pos_BL, 1 << ((CTRLPF >> 4) & 0x03)); } //CTRLPF bits 4-5, ball width
+	visible |= ball;
+	objects_visible = visible;
+	masks_dirty = 0;
+}
+
+void MemIO::render_playfield(unsigned char* pixels, int x0, int x1) { //visible pixels [x0, x1), filled run by run
+	bool score = CTRLPF & 0x02; //score mode, playfield takes the player colors
+	while (x0 < x1) {
+		int cell = x0 >> 2;
+		bool on = (pf_mask >> cell) & 1;
+		int run_end = cell + 1; //first cell with a different color
+		while ((run_end < 40) && (((pf_mask >> run_end) & 1) == on) && !(score && (run_end == 20))) { run_end++; }
+		int px_end = run_end * 4;
+		if (px_end > x1) { px_end = x1; }
+		unsigned char color = COLUBK;
+		if (on) {
+			if (score) { color = (cell < 20) ? COLUP0 : COLUP1; }
+			else { color = COLUPF; }
+		}
+		memset(pixels + x0, color, px_end - x0);
+		x0 = px_end;
+	}
+}
 
-}
\ No newline at end of file
+unsigned char MemIO::color_of_pixel(unsigned short hori_count) {
+	int cell = hori_count >> 2; //playfield cell under the pixel
+	if ((pf_mask >> cell) & 1) {
+		if (CTRLPF & 0x02) { return (cell < 20) ? COLUP0 : COLUP1; } //score mode, playfield takes the player colors
+		return COLUPF;
+	}
+	return COLUBK;
+}
+
+// ####### snapshots #####
+
+void MemIO::save_state(TiaState& state) const {
+	for (int i = 0; i < TIA_REGISTER_COUNT; i++) { state.registers[i] = this->*tia_registers[i]; }
+	state.pos_P0 = pos_P0;
+	state.pos_P1 = pos_P1;
+	state.pos_M0 = pos_M0;
+	state.pos_M1 = pos_M1;
+	state.pos_BL = pos_BL;
+	state.GRP0_old = GRP0_old;
+	state.GRP1_old = GRP1_old;
+	state.ENABL_old = ENABL_old;
+	state.vsync = vsync;
+	state.cpu_waiting = cpu_waiting;
+	state.frame_ready = frame_ready;
+	state.h_counter = h_counter;
+	state.v_counter = v_counter;
+	state.rendered_clock = rendered_clock;
+	state.frame_start_clock = frame_start_clock;
+}
+
+void MemIO::load_state(const TiaState& state) {
+	for (int i = 0; i < TIA_REGISTER_COUNT; i++) { this->*tia_registers[i] = state.registers[i]; }
+	pos_P0 = state.pos_P0;
+	pos_P1 = state.pos_P1;
+	pos_M0 = state.pos_M0;
+	pos_M1 = state.pos_M1;
+	pos_BL = state.pos_BL;
+	GRP0_old = state.GRP0_old;
+	GRP1_old = state.GRP1_old;
+	ENABL_old = state.ENABL_old;
+	vsync = state.vsync;
+	cpu_waiting = state.cpu_waiting;
+	frame_ready = state.frame_ready;
+	h_counter = state.h_counter;
+	v_counter = state.v_counter;
+	rendered_clock = state.rendered_clock;
+	frame_start_clock = state.frame_start_clock;
+	update_playfield(); //derived from the registers, marks the masks dirty too
+}
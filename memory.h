@@ -1,8 +1,14 @@
 #pragma once
 #define MEMORY_H
 
+#include <string>
 
-#include "memory.h"
+#include "compositor.h"
+#include "framebuffer.h"
+#include "riot.h"
+#include "snapshot.h"
+
+class Cartridge;
 
 
 class MemIO { 
@@ -18,16 +24,60 @@ public: //memory aspect
 		
 		unsigned char last_read; //for debugging, last value read from memory
 		unsigned char last_written; //for debugging, last value written to memory;
+
+		unsigned long long cycles; //system clock, CPU cycles elapsed since power on. Advanced by the CPU after each instruction
 		
 		//constructor
 		MemIO(int ram_size, std::string colormap_file, int horizontal_res, int vertical_res);
+		~MemIO();
+		MemIO(const MemIO&) = delete; //single live machine state, always pass by reference
+		MemIO& operator=(const MemIO&) = delete;
 		// member functions
-		unsigned char read(unsigned short address);
-		void write(unsigned short address, unsigned char value);
+		unsigned char read(unsigned short address) { //13 address lines, memory pages are read straight through their pointer
+			address = address & ADDRESS_MASK;
+			const unsigned char* page = read_page[address >> PAGE_BITS];
+			if (page != NULL) { return page[address & PAGE_MASK]; }
+			return read_device(address);
+		}
+		void write(unsigned short address, unsigned char value) {
+			address = address & ADDRESS_MASK;
+			unsigned char* page = write_page[address >> PAGE_BITS];
+			if (page != NULL) { page[address & PAGE_MASK] = value; return; }
+			write_device(address, value);
+		}
+		void poke(unsigned short address, unsigned char value); //store into the backing array whatever is mapped there (ROM loading, debugging)
 		void flush();
 
+	 // BUS
+		static const int ADDRESS_MASK = 0x1FFF; //the 6507 only has A0-A12, everything above is mirrored
+		static const int PAGE_BITS = 6; //64-byte pages, small enough that TIA, RIOT RAM and RIOT I/O never share one
+		static const int PAGE_SIZE = 1 << PAGE_BITS;
+		static const int PAGE_MASK = PAGE_SIZE - 1;
+		static const int PAGE_COUNT = (ADDRESS_MASK + 1) >> PAGE_BITS;
+		enum Device { DEV_MEMORY, DEV_TIA, DEV_RIOT_IO, DEV_ROM, DEV_CART }; //what a page is wired to, DEV_CART: hooked by the cartridge
+		const unsigned char* read_page[PAGE_COUNT]; //direct pointer to the page's bytes, NULL when reads go to the device
+		unsigned char* write_page[PAGE_COUNT]; //direct pointer to the page's bytes, NULL when writes go to the device
+		Device page_device[PAGE_COUNT];
+		unsigned int map_generation; //bumped whenever pages are remapped, never 0
+		unsigned int page_generation[PAGE_COUNT]; //map_generation when the page was last remapped, code cached from it before then is stale
+		unsigned int cache_epoch; //bumped when map_generation wraps or a cartridge is inserted, code caches drop everything they hold when it moves
+		void remap(int page, int count); //the mapping or the ROM bytes of pages [page, page + count) changed
+		bool remapped_since(int page, unsigned int generation) const { return page_generation[page] > generation; }
+		void map_pages(); //builds the page tables for the 2600 memory map
+
+	 // CARTRIDGE
+		Cartridge* cart; //NULL: cartridge space is plain ROM in mem_array, filled with poke
+		void insert_cartridge(Cartridge* cartridge); //MemIO takes ownership, the cartridge maps its banks into the page tables
+		unsigned char read_device(unsigned short address); //slow path, address already masked to 13 bits
+		void write_device(unsigned short address, unsigned char value);
+
+	 // RIOT ASPECT
+		RIOT riot; //RAM pages point into riot.ram, I/O pages go through riot.read/riot.write
+
 
 	 // TIA ASPECT
+		static const int CYCLES_PER_SCANLINE = 76; //228 color clocks, TIA runs 3 color clocks per CPU cycle
+		static const int MAX_FRAME_CYCLES = CYCLES_PER_SCANLINE * 320; //longest frame we wait for a VSYNC, a little over PAL's 312 lines
 			//TIA registers Write only
 		unsigned char VSYNC; //$00, bit 1. Vertical sync set-clear
 		unsigned char VBLANK; //$01, bits 1,6,7, vertical blank set-clear
@@ -87,31 +137,65 @@ public: //memory aspect
 		unsigned char INPT5; //$3D, bit 7, read input
 
 		//video buffer attributes
-		unsigned char** vbuffer; //buffer to display
+		FrameBuffer frame; //double-buffered display, one indexed byte per color clock
 		int horizontal_res; //resolution including blanking sections 
 		int vertical_res; // resolution including screen and vsync lines
 		//runtime attributes of tia/vbuffer
 		bool vsync; //currently in vsync?
 		int h_counter; //internal TIA horizontal counter
 		int v_counter; //virtual TIA vertical line counter, used to address buffer. DO NOT use as TIA oepration, as it has no such counter in hardware
+		unsigned long long rendered_clock; //color clock up to which the buffer has been drawn
+		unsigned long long frame_start_clock; //color clock at the start of the first scanline of the current frame
 
 		int* colormap; //array containing the RGB colors corresponding to atari 2600 colors
 
 		unsigned char check_read(unsigned short address); //check to see if read request is part of reserved TIA addresses, may need to return data if so
 		void check_write(unsigned short address, unsigned char val); //check to see if write request is part of reserved TIA addresses
-		void color_of_pixel(unsigned short hori_count); // uses internal registers to determine the color of the pixel that needs to be displayed for the display engine
+		unsigned char color_of_pixel(unsigned short hori_count); // uses internal registers to determine the color of the pixel that needs to be displayed for the display engine
+		void tia_sync(); //render everything up to the current system clock
+		void render_to(unsigned long long clock); //render every color clock since the last update up to clock, with the current registers
+		void render_span(int line, int x0, int x1); //render color clocks [x0, x1) of one scanline
+		void render_playfield(unsigned char* pixels, int x0, int x1); //fill visible pixels [x0, x1) with playfield/background runs
+		void update_playfield(); //expand PF0-2 and CTRLPF reflection into pf_mask
+		unsigned long long pf_mask; //playfield for the whole line, bit n set if 4-pixel cell n (0-39) is lit
+
+		//objects, positions are visible pixel columns (0-159)
+		unsigned char pos_P0;
+		unsigned char pos_P1;
+		unsigned char pos_M0;
+		unsigned char pos_M1;
+		unsigned char pos_BL;
+		unsigned char GRP0_old; //vertical delay copies, drawn instead of the live register when VDELxx is set
+		unsigned char GRP1_old;
+		unsigned char ENABL_old;
+		ObjectMasks masks; //every object expanded to one byte per pixel
+		bool masks_dirty; //an object register changed since masks was built
+		bool objects_visible; //a player, missile or ball is on the line, playfield-only lines skip the compositor
+		CompositeFn composite; //priority/color kernel picked for this host
+		unsigned char line_buffer[VISIBLE_PIXELS]; //compositor output for the current line
+		void build_masks();
+		void latch_collisions(unsigned short pairs);
+		unsigned char reset_position(bool player); //RESP0/1, RESM0/1, RESBL strobes
+		int missile_center(unsigned char nusiz); //RESMP0/1
 		
 
 		bool is_reserved_TIA; // TRUE if previous access was mapped to TIA
 		bool is_reserved_RIOT; //TRUE if previous access was mapped to RIOT
-		bool cpu_waiting;
+		bool cpu_waiting; //set by a WSYNC strobe, the CPU halts until the end of the scanline
+		bool frame_ready; //set when VSYNC starts, the previous frame is complete. Cleared by whoever consumes the frame
 
 		// specific TIA functions
 		void load_colormap(std::string colormap_file);
 		unsigned int get_RGB(unsigned char color_code); //returns pixel color (ASSUMES LOADED COLOR MAP!)
+		void enable_rgba(); //have frame also produce RGBA frames from the loaded colormap
+
+		// snapshots, see snapshot.h
+		void save_state(TiaState& state) const; //TIA registers, object positions and beam
+		void load_state(const TiaState& state); //also rebuilds the playfield and object masks
 
 private: // TIA private functions
 	void fct_VSYNC(unsigned char val);
+	void fct_HMOVE();
 	void fct_VBLANK();
 
 
@@ -0,0 +1,213 @@
+#include <cstring>
+
+#include "rewind.h"
+
+// ####### codec #####
+// A delta is a list of (equal run, literal run) pairs, both lengths as LEB128 varints, each literal run followed by
+// its bytes XORed with the keyframe. A literal run only ends on 3 equal bytes, so short gaps never cost more than
+// they save and the output stays within a few bytes of the input size.
+
+static int put_varint(unsigned char* out, unsigned int value) {
+	int n = 0;
+	while (value >= 0x80) {
+		out[n++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	out[n++] = value;
+	return n;
+}
+
+static unsigned int get_varint(const unsigned char* in, int in_size, int& pos) { //stops at the end of the input
+	unsigned int value = 0;
+	int shift = 0;
+	unsigned char byte;
+	do {
+		if ((pos >= in_size) || (shift > 28)) { return value; }
+		byte = in[pos++];
+		value |= (unsigned int)(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+static int equal_run(const unsigned char* a, const unsigned char* b, int from, int size) { //index of the first differing byte at or after from
+	int i = from;
+	for (; i + 8 <= size; i += 8) { //8 bytes per compare, the common case is long equal runs
+		unsigned long long x, y;
+		memcpy(&x, a + i, 8);
+		memcpy(&y, b + i, 8);
+		if (x != y) { break; }
+	}
+	while ((i < size) && (a[i] == b[i])) { i++; }
+	return i;
+}
+
+int rle_xor_encode(const unsigned char* state, const unsigned char* key, int size, unsigned char* out) {
+	int i = 0;
+	int o = 0;
+	while (i < size) {
+		int equal_start = i;
+		i = equal_run(state, key, i, size);
+		int literal_start = i;
+		while ((i < size) && !((i + 3 <= size) && (state[i] == key[i]) && (state[i + 1] == key[i + 1]) && (state[i + 2] == key[i + 2]))) { i++; }
+		o += put_varint(out + o, literal_start - equal_start);
+		o += put_varint(out + o, i - literal_start);
+		for (int j = literal_start; j < i; j++) { out[o++] = state[j] ^ key[j]; }
+	}
+	return o;
+}
+
+void rle_xor_decode(const unsigned char* in, int in_size, const unsigned char* key, int size, unsigned char* state) {
+	memcpy(state, key, size);
+	int pos = 0;
+	int i = 0;
+	while (pos < in_size) { //runs are not trusted to stay inside state or in
+		unsigned int equal = get_varint(in, in_size, pos);
+		if (equal >= (unsigned int)(size - i)) { return; }
+		i += equal;
+		unsigned int literals = get_varint(in, in_size, pos);
+		for (unsigned int j = 0; (j < literals) && (i < size) && (pos < in_size); j++) { state[i++] ^= in[pos++]; }
+	}
+}
+
+// ####### ring #####
+
+RewindBuffer::RewindBuffer(int max_frames, int arena_bytes, int keyframe_interval) {
+	this->max_frames = max_frames;
+	this->arena_bytes = arena_bytes;
+	this->keyframe_interval = keyframe_interval;
+	entries = new Entry[max_frames];
+	arena = new unsigned char[arena_bytes];
+	key_state = NULL;
+	scratch = NULL;
+	coded = NULL;
+	scratch_bytes = 0;
+	clear();
+}
+
+RewindBuffer::~RewindBuffer() {
+	delete[] entries;
+	delete[] arena;
+	delete[] key_state;
+	delete[] scratch;
+	delete[] coded;
+}
+
+void RewindBuffer::clear() {
+	first = 0;
+	count = 0;
+	first_seq = 0;
+	tail = 0;
+	since_key = 0;
+	key_seq = 0;
+	key_size = 0;
+}
+
+int RewindBuffer::bytes_used() const {
+	int used = 0;
+	for (int i = 0; i < count; i++) { used += entries[(first + i) % max_frames].size; }
+	return used;
+}
+
+void RewindBuffer::reserve(int state_size) { //scratch buffers grow to the largest snapshot seen, only on a cartridge change
+	if (state_size <= scratch_bytes) { return; }
+	delete[] key_state;
+	delete[] scratch;
+	delete[] coded;
+	key_state = new unsigned char[state_size];
+	scratch = new unsigned char[state_size];
+	coded = new unsigned char[state_size + 16];
+	scratch_bytes = state_size;
+	key_size = 0; //key_state is gone, the next frame has to be a keyframe
+}
+
+void RewindBuffer::drop_oldest() {
+	first = (first + 1) % max_frames;
+	count--;
+	first_seq++;
+	if (count == 0) { tail = 0; }
+}
+
+void RewindBuffer::drop_orphans() {
+	while ((count > 0) && !entry(0).key && (entry(0).key_seq < first_seq)) { drop_oldest(); }
+}
+
+int RewindBuffer::place(int size) {
+	if (count == max_frames) { drop_oldest(); }
+	if (tail + size > arena_bytes) { //no split frames, the end of the arena is left unused
+		while ((count > 0) && (entry(0).offset >= tail)) { drop_oldest(); } //rest of the last lap, older than what is at the start
+		tail = 0;
+	}
+	while (count > 0) { //frames from an earlier lap that overlap [tail, tail + size)
+		Entry& oldest = entry(0);
+		if ((oldest.offset < tail + size) && (oldest.offset + oldest.size > tail)) { drop_oldest(); }
+		else { break; }
+	}
+	drop_orphans();
+	int offset = tail;
+	tail = tail + size;
+	return offset;
+}
+
+void RewindBuffer::record(const Processor& cpu, const MemIO& mem) {
+	int state_size = snapshot_size(mem);
+	if (state_size > arena_bytes) { return; } //cannot hold even one frame
+	reserve(state_size);
+	save_snapshot(cpu, mem, scratch, state_size);
+
+	bool key = (key_size != state_size) || (since_key + 1 >= keyframe_interval) || (key_seq < first_seq) || (count == 0);
+	int coded_size = 0;
+	if (!key) {
+		coded_size = rle_xor_encode(scratch, key_state, state_size, coded);
+		if (coded_size >= state_size) { key = 1; } //changed too much to be worth a delta
+	}
+	Entry e;
+	e.state_size = state_size;
+	if (!key) {
+		e.offset = place(coded_size);
+		if (key_seq < first_seq) { key = 1; } //making room dropped the keyframe, store this frame whole
+		else {
+			memcpy(arena + e.offset, coded, coded_size);
+			e.size = coded_size;
+		}
+	}
+	if (key) {
+		e.offset = place(state_size);
+		memcpy(arena + e.offset, scratch, state_size);
+		e.size = state_size;
+		memcpy(key_state, scratch, state_size);
+		key_size = state_size;
+		key_seq = first_seq + count;
+		since_key = 0;
+	}
+	else { since_key++; }
+	e.key = key;
+	e.key_seq = key_seq;
+	entries[(first + count) % max_frames] = e;
+	count++;
+}
+
+bool RewindBuffer::rewind(Processor& cpu, MemIO& mem, int frames) {
+	if ((frames < 0) || (frames >= count)) { return 0; }
+	int index = count - 1 - frames;
+	Entry target = entry(index);
+	if (target.state_size > scratch_bytes) { return 0; }
+	if (target.key) { memcpy(scratch, arena + target.offset, target.state_size); }
+	else {
+		const Entry& key_entry = entry((int)(target.key_seq - first_seq));
+		rle_xor_decode(arena + target.offset, target.size, arena + key_entry.offset, target.state_size, scratch);
+	}
+	if (!load_snapshot(cpu, mem, scratch, target.state_size)) { return 0; }
+
+	count = index + 1; //forget the frames after the target, recording goes on from it
+	tail = target.offset + target.size;
+	if (target.key) { since_key = 0; }
+	else { since_key = (int)(first_seq + index - target.key_seq); }
+	if (key_seq != target.key_seq) { //latest keyframe was dropped with the newer frames, go back to the target's one
+		const Entry& key_entry = entry((int)(target.key_seq - first_seq));
+		memcpy(key_state, arena + key_entry.offset, key_entry.state_size);
+		key_size = key_entry.state_size;
+		key_seq = target.key_seq;
+	}
+	return 1;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#define REWIND_H
+
+#include "cpu.h"
+#include "memory.h"
+#include "snapshot.h"
+
+// Rewind history. One snapshot is recorded per frame into a fixed byte arena used as a ring. Every keyframe_interval
+// frames a keyframe is stored as it is; the frames in between are stored as the XOR of their snapshot with that
+// keyframe, which is almost all zeros, run-length coded. Only the bytes that moved are kept, so a few megabytes hold
+// minutes of history. The oldest frames are dropped when the arena or the frame slots run out, a keyframe always
+// together with the deltas that need it.
+
+class RewindBuffer {
+public:
+	RewindBuffer(int max_frames, int arena_bytes, int keyframe_interval = 60);
+	~RewindBuffer();
+	RewindBuffer(const RewindBuffer&) = delete;
+	RewindBuffer& operator=(const RewindBuffer&) = delete;
+
+	void record(const Processor& cpu, const MemIO& mem); //store the current state, meant to be called once per frame
+	bool rewind(Processor& cpu, MemIO& mem, int frames); //restore the state recorded frames records before the latest (0: latest), newer ones are dropped. FALSE if not that much history
+	void clear();
+
+	int frames_stored() const { return count; }
+	int bytes_used() const; //arena bytes held by stored frames
+
+private:
+	struct Entry {
+		int offset; //in arena
+		int size; //encoded bytes
+		int state_size; //snapshot bytes once decoded
+		bool key; //stored as it is, otherwise an RLE XOR delta against frame key_seq
+		unsigned long long key_seq;
+	};
+	Entry* entries; //ring of frames, oldest at first
+	int max_frames;
+	int first;
+	int count;
+	unsigned long long first_seq; //sequence number of the oldest frame, frames are numbered from 0 in recording order
+
+	unsigned char* arena;
+	int arena_bytes;
+	int tail; //where the next frame goes
+
+	int keyframe_interval;
+	int since_key; //frames recorded since the last keyframe
+	unsigned long long key_seq; //latest keyframe
+	unsigned char* key_state; //its snapshot, deltas are taken against this copy
+	int key_size;
+
+	unsigned char* scratch; //snapshot being recorded or decoded
+	unsigned char* coded; //delta being encoded, worst case a little over the snapshot size
+	int scratch_bytes;
+
+	Entry& entry(int index) { return entries[(first + index) % max_frames]; } //0 is the oldest
+	void reserve(int state_size);
+	int place(int size); //arena offset for size bytes, drops the oldest frames in the way
+	void drop_oldest();
+	void drop_orphans(); //deltas at the front whose keyframe is gone
+};
+
+int rle_xor_encode(const unsigned char* state, const unsigned char* key, int size, unsigned char* out); //bytes written, at most size + size / 64 + 8
+void rle_xor_decode(const unsigned char* in, int in_size, const unsigned char* key, int size, unsigned char* state);
@@ -0,0 +1,117 @@
+#include <cstring>
+
+#include "riot.h"
+
+RIOT::RIOT() {
+	for (int i = 0; i < 128; i++) { ram[i] = 0; }
+	SWCHA = 0;
+	SWACNT = 0; //both ports are inputs at power on
+	SWCHB = 0;
+	SWBCNT = 0;
+	port_a_input = 0xFF; //joysticks centered
+	port_b_input = 0x0B; //reset and select released, color TV, both difficulties on B
+	timer_start = 0;
+	timer_value = 0;
+	timer_shift = 10; //random at power on, games always set the timer before reading it
+	timint_cleared = 0;
+}
+
+unsigned char RIOT::read(unsigned short address, unsigned long long cycle) {
+	if (address & 0x04) { //A2: timer
+		if (address & 0x01) { return TIMINT(cycle); }
+		return INTIM(cycle);
+	}
+	switch (address & 0x03) {
+	case 0x00:
+		return (SWCHA & SWACNT) | (port_a_input & ~SWACNT); //output bits read back the latch
+	case 0x01:
+		return SWACNT;
+	case 0x02:
+		return (SWCHB & SWBCNT) | (port_b_input & ~SWBCNT);
+	default:
+		return SWBCNT;
+	}
+}
+
+void RIOT::write(unsigned short address, unsigned char value, unsigned long long cycle) {
+	if (address & 0x04) { //A2: timer, or PA7 edge detect control when A4 is low
+		if (address & 0x10) {
+			static const int shifts[4] = { 0, 3, 6, 10 }; //TIM1T, TIM8T, TIM64T, T1024T
+			timer_start = cycle;
+			timer_value = value;
+			timer_shift = shifts[address & 0x03];
+			timint_cleared = 0;
+		}
+		return; //PA7 edge interrupts are not wired on the 2600
+	}
+	switch (address & 0x03) {
+	case 0x00:
+		SWCHA = value;
+		break;
+	case 0x01:
+		SWACNT = value;
+		break;
+	case 0x02:
+		SWCHB = value;
+		break;
+	default:
+		SWBCNT = value;
+		break;
+	}
+}
+
+unsigned long long RIOT::underflow_cycle() {
+	return timer_start + 1 + ((unsigned long long)timer_value << timer_shift); //first decrement one cycle after the write, then one per interval
+}
+
+unsigned char RIOT::INTIM(unsigned long long cycle) {
+	unsigned long long wrap = underflow_cycle();
+	if (cycle >= wrap) { //past zero, counts down from $FF once per cycle
+		timint_cleared = 1; //reading the timer clears the interrupt flag
+		return (unsigned char)(0xFF - (cycle - wrap));
+	}
+	unsigned long long elapsed = cycle - timer_start;
+	unsigned long long ticks = (elapsed + (1ull << timer_shift) - 1) >> timer_shift;
+	return (unsigned char)(timer_value - ticks);
+}
+
+unsigned char RIOT::TIMINT(unsigned long long cycle) {
+	if ((cycle >= underflow_cycle()) && !timint_cleared) { return 0x80; }
+	return 0x00;
+}
+
+unsigned long long RIOT::next_change(unsigned long long cycle) {
+	unsigned long long wrap = underflow_cycle();
+	if (cycle >= wrap) { return cycle + 1; } //one tick per cycle past zero
+	if (cycle < timer_start + 1) { return timer_start + 1; }
+	unsigned long long interval = 1ull << timer_shift;
+	return timer_start + 1 + ((cycle - timer_start - 1) / interval + 1) * interval; //next decrement, the last one is the wrap
+}
+
+void RIOT::save_state(RiotState& state) const {
+	memcpy(state.ram, ram, sizeof(ram));
+	state.SWCHA = SWCHA;
+	state.SWACNT = SWACNT;
+	state.SWCHB = SWCHB;
+	state.SWBCNT = SWBCNT;
+	state.port_a_input = port_a_input;
+	state.port_b_input = port_b_input;
+	state.timer_value = timer_value;
+	state.timer_shift = timer_shift;
+	state.timint_cleared = timint_cleared;
+	state.timer_start = timer_start;
+}
+
+void RIOT::load_state(const RiotState& state) {
+	memcpy(ram, state.ram, sizeof(ram));
+	SWCHA = state.SWCHA;
+	SWACNT = state.SWACNT;
+	SWCHB = state.SWCHB;
+	SWBCNT = state.SWBCNT;
+	port_a_input = state.port_a_input;
+	port_b_input = state.port_b_input;
+	timer_value = state.timer_value;
+	timer_shift = state.timer_shift;
+	timint_cleared = state.timint_cleared;
+	timer_start = state.timer_start;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#define RIOT_H
+
+#include "snapshot.h"
+
+// MOS 6532 RAM-I/O-Timer. 128 bytes of RAM, two 8-bit ports (joysticks on A, console switches on B) and the interval
+// timer. The timer is never ticked: a write records the cycle it happened on and INTIM/TIMINT are worked out from the
+// elapsed cycles when the program reads them.
+
+class RIOT {
+public:
+	RIOT();
+
+	unsigned char ram[128]; //$80-$FF, mapped directly by the bus page tables
+
+	unsigned char read(unsigned short address, unsigned long long cycle); //I/O and timer registers, $280-$29F and mirrors
+	void write(unsigned short address, unsigned char value, unsigned long long cycle);
+
+	//ports, bits read 1 when the line is released
+	unsigned char SWCHA; //$280, port A output latch (joystick directions)
+	unsigned char SWACNT; //$281, port A direction, 1 = output
+	unsigned char SWCHB; //$282, port B output latch (console switches)
+	unsigned char SWBCNT; //$283, port B direction, 1 = output
+	unsigned char port_a_input; //joystick lines as driven by the controllers
+	unsigned char port_b_input; //console switches as set by the front end
+
+	//timer
+	unsigned char INTIM(unsigned long long cycle); //$284, current timer value
+	unsigned char TIMINT(unsigned long long cycle); //$285, bit 7 set once the timer went through zero
+	unsigned long long next_change(unsigned long long cycle); //first cycle after cycle at which INTIM or TIMINT read differently
+
+	void save_state(RiotState& state) const;
+	void load_state(const RiotState& state);
+
+private:
+	unsigned long long timer_start; //cycle of the last TIM1T/TIM8T/TIM64T/T1024T write
+	unsigned char timer_value; //value written
+	int timer_shift; //log2 of the interval: 0, 3, 6 or 10
+	bool timint_cleared; //INTIM was read after the underflow, TIMINT bit 7 reads 0 until the next timer write
+	unsigned long long underflow_cycle(); //cycle at which the counter wraps to $FF and switches to one tick per cycle
+};
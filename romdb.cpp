@@ -0,0 +1,194 @@
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#include "romdb.h"
+#include "cartridge.h"
+
+// ####### MD5 (RFC 1321) #####
+
+static const unsigned int md5_k[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+static const unsigned char md5_shift[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static void md5_block(unsigned int state[4], const unsigned char* block) {
+	unsigned int w[16];
+	for (int i = 0; i < 16; i++) { //little endian words, whatever the host
+		w[i] = block[i * 4] | (block[i * 4 + 1] << 8) | (block[i * 4 + 2] << 16) | ((unsigned int)block[i * 4 + 3] << 24);
+	}
+	unsigned int a = state[0], b = state[1], c = state[2], d = state[3];
+	for (int i = 0; i < 64; i++) {
+		unsigned int f;
+		int g;
+		if (i < 16) { f = (b & c) | (~b & d); g = i; }
+		else if (i < 32) { f = (d & b) | (~d & c); g = (5 * i + 1) & 15; }
+		else if (i < 48) { f = b ^ c ^ d; g = (3 * i + 5) & 15; }
+		else { f = c ^ (b | ~d); g = (7 * i) & 15; }
+		f += a + md5_k[i] + w[g];
+		a = d;
+		d = c;
+		c = b;
+		b += (f << md5_shift[i]) | (f >> (32 - md5_shift[i]));
+	}
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+}
+
+std::string md5_hex(const unsigned char* data, int size) {
+	unsigned int state[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+	int whole = size & ~63;
+	for (int i = 0; i < whole; i += 64) { md5_block(state, data + i); }
+
+	unsigned char tail[128]; //last partial block, the 0x80 marker and the bit length, one or two blocks
+	int rest = size - whole;
+	memset(tail, 0, sizeof(tail));
+	memcpy(tail, data + whole, rest);
+	tail[rest] = 0x80;
+	int tail_size = (rest < 56) ? 64 : 128;
+	unsigned long long bits = (unsigned long long)size * 8;
+	for (int i = 0; i < 8; i++) { tail[tail_size - 8 + i] = (unsigned char)(bits >> (8 * i)); }
+	for (int i = 0; i < tail_size; i += 64) { md5_block(state, tail + i); }
+
+	char hex[33];
+	for (int i = 0; i < 16; i++) { sprintf(hex + i * 2, "%02x", (state[i / 4] >> (8 * (i % 4))) & 0xFF); }
+	return std::string(hex, 32);
+}
+
+// ####### database #####
+
+// Images the heuristics get wrong, or that need something other than NTSC and joysticks (PAL releases, paddle,
+// keypad and driving controller games). Rows use the MD5 digests of the usual 2600 databases, each checked against
+// the dump it describes, and must stay sorted by digest. The last row is an end marker and is never matched.
+static const RomEntry rom_table[] = {
+	{ "~", "", TvStandard::NTSC, Controller::JOYSTICK, Controller::JOYSTICK, "" }
+};
+static const int rom_count = sizeof(rom_table) / sizeof(rom_table[0]) - 1;
+
+const RomEntry* rom_database(int& count) {
+	count = rom_count;
+	return rom_table;
+}
+
+const RomEntry* find_rom(const std::string& md5, const RomEntry* table, int count) {
+	const RomEntry* end = table + count;
+	const RomEntry* entry = std::lower_bound(table, end, md5, [](const RomEntry& e, const std::string& key) { return strcmp(e.md5, key.c_str()) < 0; });
+	if (entry != end && md5 == entry->md5) { return entry; }
+	return NULL;
+}
+
+// ####### heuristics #####
+
+struct Signature {
+	unsigned char bytes[5];
+	int length;
+};
+
+static int count_signature(const unsigned char* image, int size, const Signature& sig, int enough) { //occurrences, counting stops at enough
+	int count = 0;
+	const unsigned char* p = image;
+	const unsigned char* last = image + size - sig.length;
+	while (p <= last) {
+		p = (const unsigned char*)memchr(p, sig.bytes[0], last - p + 1); //skip to the next candidate first byte
+		if (p == NULL) { break; }
+		if (memcmp(p, sig.bytes, sig.length) == 0 && ++count >= enough) { break; }
+		p++;
+	}
+	return count;
+}
+
+static bool has_any(const unsigned char* image, int size, const Signature* sigs, int count) {
+	for (int i = 0; i < count; i++) {
+		if (count_signature(image, size, sigs[i], 1) > 0) { return 1; }
+	}
+	return 0;
+}
+
+static const Signature e0_signatures[] = { //hotspot accesses in $1FE0-$1FF7 (or a mirror)
+	{ { 0x8D, 0xE0, 0x1F }, 3 }, { { 0x8D, 0xE0, 0x5F }, 3 }, { { 0x8D, 0xE9, 0xFF }, 3 }, { { 0x0C, 0xE0, 0x1F }, 3 },
+	{ { 0xAD, 0xE0, 0x1F }, 3 }, { { 0xAD, 0xE9, 0xFF }, 3 }, { { 0xAD, 0xED, 0xFF }, 3 }, { { 0xAD, 0xF3, 0xBF }, 3 }
+};
+static const Signature e7_signatures[] = { //hotspot accesses in $1FE0-$1FEB
+	{ { 0xAD, 0xE2, 0xFF }, 3 }, { { 0xAD, 0xE5, 0xFF }, 3 }, { { 0xAD, 0xE5, 0x1F }, 3 }, { { 0xAD, 0xE7, 0x1F }, 3 },
+	{ { 0x0C, 0xE7, 0x1F }, 3 }, { { 0x8D, 0xE7, 0xFF }, 3 }, { { 0x8D, 0xE7, 0x1F }, 3 }
+};
+static const Signature fe_signatures[] = { //JSR/RTS sequences of the Activision FE games
+	{ { 0x20, 0x00, 0xD0, 0xC6, 0xC5 }, 5 }, { { 0x20, 0xC3, 0xF8, 0xA5, 0x82 }, 5 },
+	{ { 0xD0, 0xFB, 0x20, 0x73, 0xFE }, 5 }, { { 0x20, 0x00, 0xF0, 0x84, 0xD6 }, 5 }
+};
+static const Signature sta_3f = { { 0x85, 0x3F }, 2 }; //STA $3F, the 3F bank select
+
+static bool probably_3f(const unsigned char* image, int size) {
+	return count_signature(image, size, sta_3f, 2) >= 2; //one could be a plain TIA write, two hardly ever are
+}
+
+static bool probably_superchip(const unsigned char* image, int size) { //SC images leave the RAM area of every 4K bank blank
+	for (int bank = 0; bank < size; bank += 0x1000) {
+		for (int i = 1; i < 0x100; i++) {
+			if (image[bank + i] != image[bank]) { return 0; }
+		}
+	}
+	return 1;
+}
+
+std::string guess_scheme(const unsigned char* image, int size) {
+	switch (size) {
+	case 0x2000:
+		if (probably_superchip(image, size)) { return "F8SC"; }
+		if (has_any(image, size, e0_signatures, sizeof(e0_signatures) / sizeof(Signature))) { return "E0"; }
+		if (probably_3f(image, size)) { return "3F"; }
+		if (has_any(image, size, fe_signatures, sizeof(fe_signatures) / sizeof(Signature))) { return "FE"; }
+		return "F8";
+	case 0x4000:
+		if (probably_superchip(image, size)) { return "F6SC"; }
+		if (has_any(image, size, e7_signatures, sizeof(e7_signatures) / sizeof(Signature))) { return "E7"; }
+		if (probably_3f(image, size)) { return "3F"; }
+		return "F6";
+	case 0x8000:
+		if (probably_superchip(image, size)) { return "F4SC"; }
+		if (probably_3f(image, size)) { return "3F"; }
+		return "F4";
+	}
+	std::string scheme = Cartridge::default_scheme(size); //2K, 4K, DPC
+	if (scheme == "" && size > 0x8000 && (size % 0x800) == 0 && probably_3f(image, size)) { return "3F"; } //only 3F goes past 32K
+	return scheme;
+}
+
+RomInfo identify_rom(const unsigned char* image, int size, const RomEntry* table, int count) {
+	RomInfo info;
+	info.md5 = md5_hex(image, size);
+	const RomEntry* entry = find_rom(info.md5, table, count);
+	if (entry != NULL) {
+		info.scheme = entry->scheme;
+		info.tv = entry->tv;
+		info.left = entry->left;
+		info.right = entry->right;
+		info.name = entry->name;
+		info.known = 1;
+		return info;
+	}
+	info.scheme = guess_scheme(image, size);
+	info.tv = TvStandard::NTSC;
+	info.left = Controller::JOYSTICK;
+	info.right = Controller::JOYSTICK;
+	info.known = 0;
+	return info;
+}
+
+RomInfo identify_rom(const unsigned char* image, int size) {
+	return identify_rom(image, size, rom_table, rom_count);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#define ROMDB_H
+
+#include <string>
+
+// ROM identification. An image is hashed once (MD5, the key used by the usual 2600 property databases, so their
+// entries can be copied over as they are) and looked up in a table sorted by digest, the embedded one or rows the
+// caller read from a property file. Unknown images fall back to a signature scan: the image size narrows the
+// candidate schemes, then the opcodes that hit each scheme's hotspots (e.g. LDA $1FE0 for E0, STA $3F for 3F) decide
+// between them. Nothing is ever run.
+
+enum class TvStandard { NTSC, PAL, SECAM };
+enum class Controller { JOYSTICK, PADDLES, KEYPAD, DRIVING };
+
+struct RomEntry { //one row of a property table
+	const char* md5; //lowercase hex, tables are sorted on it
+	const char* scheme;
+	TvStandard tv;
+	Controller left;
+	Controller right;
+	const char* name;
+};
+
+struct RomInfo {
+	std::string md5; //hex digest of the whole image
+	std::string scheme; //bank-switching scheme as understood by Cartridge::create, "" if nothing fits
+	TvStandard tv; //NTSC and joysticks unless the table says otherwise, nothing in the image tells
+	Controller left; //controller in the left port
+	Controller right;
+	std::string name; //title, "" unless found in the table
+	bool known; //found in the table, otherwise everything but md5 was guessed
+};
+
+RomInfo identify_rom(const unsigned char* image, int size); //embedded table first, heuristics if the image is not in it
+RomInfo identify_rom(const unsigned char* image, int size, const RomEntry* table, int count); //same with another table, sorted by md5
+const RomEntry* find_rom(const std::string& md5, const RomEntry* table, int count); //binary search, NULL if absent
+const RomEntry* rom_database(int& count); //the embedded table
+std::string guess_scheme(const unsigned char* image, int size); //heuristics only
+std::string md5_hex(const unsigned char* data, int size); //32 lowercase hex digits
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <cstring>
+
+#include "romimage.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RomImage::RomImage() {
+	data = NULL;
+	size = 0;
+	mapped = 0;
+	owned = NULL;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#endif
+}
+
+RomImage* RomImage::copy_of(const unsigned char* bytes, int size) {
+	RomImage* image = new RomImage();
+	image->owned = new unsigned char[size];
+	memcpy(image->owned, bytes, size);
+	image->data = image->owned;
+	image->size = size;
+	return image;
+}
+
+RomImage* RomImage::borrow(const RomImage& source) {
+	RomImage* image = new RomImage(); //neither mapped nor owned, the destructor leaves the bytes alone
+	image->data = source.data;
+	image->size = source.size;
+	return image;
+}
+
+#ifdef _WIN32
+
+RomImage* RomImage::map_file(std::string filename) {
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		std::cerr << "Error opening file" << std::endl;
+		return NULL;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || file_size.QuadPart > 0x7FFFFFFF) {
+		std::cerr << "Error opening file: empty or too large" << std::endl;
+		CloseHandle(file);
+		return NULL;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* view = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (view == NULL) {
+		std::cerr << "Error mapping file" << std::endl;
+		if (mapping != NULL) { CloseHandle(mapping); }
+		CloseHandle(file);
+		return NULL;
+	}
+	RomImage* image = new RomImage();
+	image->data = (const unsigned char*)view;
+	image->size = (int)file_size.QuadPart;
+	image->mapped = 1;
+	image->file = file;
+	image->mapping = mapping;
+	return image;
+}
+
+RomImage::~RomImage() {
+	if (mapped) {
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+		CloseHandle(file);
+	}
+	delete[] owned;
+}
+
+#else
+
+RomImage* RomImage::map_file(std::string filename) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Error opening file" << std::endl;
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0 || info.st_size > 0x7FFFFFFF) {
+		std::cerr << "Error opening file: empty or too large" << std::endl;
+		close(fd);
+		return NULL;
+	}
+	void* view = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); //the mapping keeps the file referenced
+	if (view == MAP_FAILED) {
+		std::cerr << "Error mapping file" << std::endl;
+		return NULL;
+	}
+	RomImage* image = new RomImage();
+	image->data = (const unsigned char*)view;
+	image->size = (int)info.st_size;
+	image->mapped = 1;
+	return image;
+}
+
+RomImage::~RomImage() {
+	if (mapped) { munmap((void*)data, size); }
+	delete[] owned;
+}
+
+#endif
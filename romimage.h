@@ -0,0 +1,30 @@
+#pragma once
+#define ROMIMAGE_H
+
+#include <string>
+
+// Read-only ROM bytes. Files are memory-mapped rather than read into the heap, so every emulator on the host running
+// the same ROM shares one physical copy through the page cache, and loading costs no copy at all. Cartridges borrow
+// the bytes for their whole life and point the bus page tables straight into them.
+
+class RomImage {
+public:
+	static RomImage* map_file(std::string filename); //NULL if the file cannot be opened or is empty
+	static RomImage* copy_of(const unsigned char* bytes, int size); //heap copy, for images that do not come from a file
+	static RomImage* borrow(const RomImage& source); //view of source's bytes, source must outlive it
+	~RomImage();
+	RomImage(const RomImage&) = delete;
+	RomImage& operator=(const RomImage&) = delete;
+
+	const unsigned char* data;
+	int size;
+	bool mapped; //data is a file mapping, otherwise a heap block or borrowed
+
+private:
+	RomImage();
+	unsigned char* owned; //heap block of copy_of
+#ifdef _WIN32
+	void* file; //HANDLEs of the mapping
+	void* mapping;
+#endif
+};
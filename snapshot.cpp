@@ -0,0 +1,59 @@
+#include <cstring>
+
+#include "snapshot.h"
+#include "cpu.h"
+#include "memory.h"
+#include "cartridge.h"
+
+static int cart_state_size(const MemIO& mem) {
+	if (mem.cart == NULL) { return 0; } //plain ROM in mem_array, nothing to save
+	return mem.cart->state_size();
+}
+
+static void cart_identity(const MemIO& mem, char* scheme, int& rom_size) { //scheme zero padded, "" without a cartridge
+	memset(scheme, 0, sizeof(MachineState::scheme));
+	rom_size = 0;
+	if (mem.cart == NULL) { return; }
+	strncpy(scheme, mem.cart->scheme.c_str(), sizeof(MachineState::scheme) - 1);
+	rom_size = mem.cart->rom_size;
+}
+
+int snapshot_size(const MemIO& mem) {
+	return sizeof(MachineState) + cart_state_size(mem);
+}
+
+int save_snapshot(const Processor& cpu, const MemIO& mem, unsigned char* buffer, int capacity) {
+	int size = snapshot_size(mem);
+	if (capacity < size) { return 0; }
+	MachineState state; //built on the stack then copied, buffer needs no particular alignment
+	memset(&state, 0, sizeof(state)); //padding too, identical states give identical bytes
+	state.magic = SNAPSHOT_MAGIC;
+	state.version = SNAPSHOT_VERSION;
+	state.cart_size = cart_state_size(mem);
+	cart_identity(mem, state.scheme, state.rom_size);
+	state.cycles = mem.cycles;
+	cpu.save_state(state.cpu);
+	mem.save_state(state.tia);
+	mem.riot.save_state(state.riot);
+	memcpy(buffer, &state, sizeof(state));
+	if (state.cart_size > 0) { mem.cart->save_state(buffer + sizeof(state)); }
+	return size;
+}
+
+bool load_snapshot(Processor& cpu, MemIO& mem, const unsigned char* buffer, int size) {
+	MachineState state;
+	if (size < (int)sizeof(state)) { return 0; }
+	memcpy(&state, buffer, sizeof(state));
+	if ((state.magic != SNAPSHOT_MAGIC) || (state.version != SNAPSHOT_VERSION)) { return 0; }
+	if ((state.cart_size != cart_state_size(mem)) || (size < snapshot_size(mem))) { return 0; } //taken with another cartridge
+	char scheme[sizeof(state.scheme)];
+	int rom_size;
+	cart_identity(mem, scheme, rom_size);
+	if ((memcmp(scheme, state.scheme, sizeof(scheme)) != 0) || (rom_size != state.rom_size)) { return 0; }
+	if ((state.cart_size > 0) && !mem.cart->load_state(buffer + sizeof(state))) { return 0; } //a bank this ROM does not have, checked before anything changed
+	mem.cycles = state.cycles;
+	cpu.load_state(state.cpu);
+	mem.load_state(state.tia);
+	mem.riot.load_state(state.riot);
+	return 1;
+}
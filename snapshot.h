@@ -0,0 +1,75 @@
+#pragma once
+#define SNAPSHOT_H
+
+// Machine snapshots. The whole emulated state (CPU, TIA, RIOT, cartridge banking and cycle counters) is copied into
+// plain structs laid end to end in one buffer: a header, the fixed-size part, then a few bytes of cartridge state.
+// A 2K/4K game takes a few hundred bytes and a save or restore is a handful of memcpys, so searches can branch from
+// the same state millions of times. The layout is the in-memory one: snapshots are for the build that made them, the
+// version number changes whenever a struct below does. The picture in the frame buffer is output, not state.
+
+class Processor;
+class MemIO;
+
+static const unsigned int SNAPSHOT_MAGIC = 0x36324D53; //"SM26" in little endian byte order
+static const unsigned short SNAPSHOT_VERSION = 2;
+static const int TIA_REGISTER_COUNT = 53; //write registers $00-$2C that exist, then the read registers $30-$3D
+
+struct CpuState {
+	unsigned short PC;
+	unsigned char A;
+	unsigned char X;
+	unsigned char Y;
+	unsigned char SP;
+	unsigned char SR; //packed with pack_SR, break bits included
+	unsigned char waiting;
+	int step; //cpu_tick: cycles left of the current instruction
+};
+
+struct TiaState {
+	unsigned char registers[TIA_REGISTER_COUNT]; //in MemIO declaration order, VSYNC to INPT5
+	unsigned char pos_P0;
+	unsigned char pos_P1;
+	unsigned char pos_M0;
+	unsigned char pos_M1;
+	unsigned char pos_BL;
+	unsigned char GRP0_old;
+	unsigned char GRP1_old;
+	unsigned char ENABL_old;
+	unsigned char vsync;
+	unsigned char cpu_waiting;
+	unsigned char frame_ready;
+	int h_counter;
+	int v_counter;
+	unsigned long long rendered_clock;
+	unsigned long long frame_start_clock;
+};
+
+struct RiotState {
+	unsigned char ram[128];
+	unsigned char SWCHA;
+	unsigned char SWACNT;
+	unsigned char SWCHB;
+	unsigned char SWBCNT;
+	unsigned char port_a_input;
+	unsigned char port_b_input;
+	unsigned char timer_value;
+	unsigned char timer_shift;
+	unsigned char timint_cleared;
+	unsigned long long timer_start;
+};
+
+struct MachineState { //start of every snapshot, Cartridge::save_state bytes follow
+	unsigned int magic;
+	unsigned short version;
+	unsigned short cart_size; //bytes of cartridge state after this struct
+	char scheme[8]; //cartridge it was taken with, several schemes share a state size
+	int rom_size;
+	unsigned long long cycles; //MemIO::cycles
+	CpuState cpu;
+	TiaState tia;
+	RiotState riot;
+};
+
+int snapshot_size(const MemIO& mem); //bytes save_snapshot needs for this machine, fixed for a given cartridge
+int save_snapshot(const Processor& cpu, const MemIO& mem, unsigned char* buffer, int capacity); //bytes written, 0 if capacity is too small
+bool load_snapshot(Processor& cpu, MemIO& mem, const unsigned char* buffer, int size); //FALSE (machine untouched) if the buffer is not a snapshot of this version and cartridge
@@ -0,0 +1,27 @@
+#pragma once
+#define CHECK_H
+
+#include <iostream>
+
+// Regression test checks. A failed CHECK prints where it was and the run goes on, tests.cpp counts the failures.
+
+extern int checks_run;
+extern int checks_failed;
+
+#define CHECK(condition) do { \
+	checks_run++; \
+	if (!(condition)) { \
+		checks_failed++; \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" << #condition << ") failed" << std::endl; \
+	} \
+} while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+	checks_run++; \
+	long long expected_value = (long long)(expected); \
+	long long actual_value = (long long)(actual); \
+	if (expected_value != actual_value) { \
+		checks_failed++; \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << #actual << " is " << actual_value << ", expected " << expected_value << std::endl; \
+	} \
+} while (0)
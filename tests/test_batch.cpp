@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "../batch.h"
+#include "../snapshot.h"
+
+// Stepping the batch on a pool must give what the plain loop gives: the same frames, RAM and frame_done for every
+// instance, whatever thread runs which instance. Each instance gets its own joystick and fire inputs and the program
+// draws from them, so a mixed-up slot shows. reset() must bring an instance back to exactly the state load left it in.
+
+static const unsigned char kernel[] = { //$F000
+	0x78, 0xD8, 0xA2, 0xFF, 0x9A, //SEI, CLD, LDX #$FF, TXS
+	0xA9, 0x02, 0x85, 0x00, 0x85, 0x02, 0x85, 0x02, 0x85, 0x02, 0xA9, 0x00, 0x85, 0x00, //frame: three lines of VSYNC
+	0xAD, 0x80, 0x02, 0x85, 0x81, //LDA SWCHA, STA $81
+	0xA5, 0x0C, 0x85, 0x82, //LDA INPT4, STA $82
+	0xE6, 0x80, 0xA5, 0x80, 0x45, 0x81, 0x65, 0x82, //INC $80, LDA $80, EOR $81, ADC $82
+	0xA2, 0xC8, 0x85, 0x09, 0x85, 0x02, 0x69, 0x03, 0xCA, 0xD0, 0xF7, //LDX #200, line: STA COLUBK, STA WSYNC, ADC #3, DEX, BNE line
+	0x85, 0x83, 0x4C, 0x05, 0xF0, //STA $83, JMP frame
+};
+
+static std::vector<unsigned char> image() {
+	std::vector<unsigned char> rom(0x1000, 0xEA);
+	std::copy(kernel, kernel + sizeof(kernel), rom.begin());
+	rom[0xFFC] = 0x00;
+	rom[0xFFD] = 0xF0;
+	return rom;
+}
+
+static void press(BatchEmulator& batch, int frame) { //different inputs per instance and per frame
+	for (int i = 0; i < batch.count; i++) {
+		batch.port_a[i] = (unsigned char)(0xFF ^ ((i * 16 + frame) & 0xF0));
+		batch.fire[i] = (unsigned char)((i + frame) % 3);
+	}
+}
+
+static bool same_observations(const BatchEmulator& a, const BatchEmulator& b) {
+	if (memcmp(a.frames, b.frames, a.frame_bytes * a.count) != 0) { return 0; }
+	if (memcmp(a.ram, b.ram, (size_t)128 * a.count) != 0) { return 0; }
+	return memcmp(a.frame_done, b.frame_done, a.count) == 0;
+}
+
+static std::vector<unsigned char> state(BatchEmulator& batch, int index) {
+	std::vector<unsigned char> snapshot(snapshot_size(batch.machine(index)));
+	CHECK_EQUAL((int)snapshot.size(), batch.save_state(index, snapshot.data(), (int)snapshot.size()));
+	return snapshot;
+}
+
+void test_batch() {
+	const int count = 13;
+	std::vector<unsigned char> rom = image();
+	BatchEmulator serial(count);
+	CHECK_EQUAL(0, serial.load(rom.data(), (int)rom.size(), "4K"));
+	CHECK_EQUAL(-1, serial.load(NULL, 0));
+	std::vector<unsigned char> power_on = state(serial, 0);
+
+	static const int thread_counts[] = { 1, 3, 4, 16 };
+	for (int threads : thread_counts) {
+		ThreadPool pool(threads);
+		BatchEmulator pooled(count);
+		CHECK_EQUAL(0, pooled.load(rom.data(), (int)rom.size(), "4K"));
+		serial.reset_all();
+		CHECK(same_observations(serial, pooled));
+		for (int frame = 0; frame < 6; frame++) {
+			press(serial, frame);
+			press(pooled, frame);
+			serial.step();
+			if (frame % 2) { pooled.step(pool); }
+			else { pooled.step_range(0, count / 2); pooled.step_range(count / 2, count); } //callers splitting it themselves
+			CHECK(same_observations(serial, pooled));
+			for (int i = 0; i < count; i++) { CHECK(state(serial, i) == state(pooled, i)); }
+		}
+	}
+	int done = 0;
+	for (int i = 0; i < count; i++) { done = done + serial.frame_done[i]; }
+	CHECK_EQUAL(count, done);
+	CHECK(memcmp(serial.ram_of(0), serial.ram_of(1), 128) != 0); //the inputs reached the instances, slots are told apart
+	CHECK(memcmp(serial.frame(0), serial.frame(1), serial.frame_bytes) != 0);
+
+	BatchEmulator fresh(count);
+	CHECK_EQUAL(0, fresh.load(rom.data(), (int)rom.size(), "4K"));
+	serial.reset(5);
+	CHECK(state(serial, 5) == power_on);
+	CHECK(state(serial, 6) != power_on); //only the one asked for
+	CHECK_EQUAL(0, serial.frame_done[5]);
+	CHECK(memcmp(serial.ram_of(5), fresh.ram_of(5), 128) == 0);
+	CHECK(memcmp(serial.frame(5), fresh.frame(5), serial.frame_bytes) == 0);
+	press(serial, 0);
+	press(fresh, 0);
+	serial.step();
+	fresh.step();
+	CHECK(state(serial, 5) == state(fresh, 5)); //and runs on from there like a new one
+	CHECK(memcmp(serial.frame(5), fresh.frame(5), serial.frame_bytes) == 0);
+	CHECK(memcmp(serial.ram_of(5), fresh.ram_of(5), 128) == 0);
+}
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "../cartridge.h"
+#include "../cpu.h"
+
+// Instruction results checked against what the 6502 does, one case per bug the dispatch table rewrite fixed: BRK
+// falling through into BVC, BIT testing A instead of memory, ADC/SBC overflow, ROL dropping the old carry, branch
+// targets and timing, indirect pointers wrapping in zero page. The opcode table is also held against 6502ops.csv.
+
+struct Rig { //4K ROM at $F000, one instruction per step, no idle loop skipping
+	MemIO mem;
+	Processor cpu;
+	Rig(const std::vector<unsigned char>& image) : mem(0x10000, "colors.csv", 228, 262), cpu(mem) {
+		mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "4K"));
+		cpu.reset(mem);
+		cpu.set_idle_skip(0);
+	}
+	int step(unsigned short pc) { //cycles taken by the instruction at pc
+		cpu.PC = pc;
+		return (int)cpu.run_cycles(mem, 1);
+	}
+};
+
+static std::vector<unsigned char> rom() {
+	std::vector<unsigned char> image(0x1000, 0xEA);
+	image[0xFFC] = 0x00; //reset to $F000
+	image[0xFFD] = 0xF0;
+	return image;
+}
+
+static void place(std::vector<unsigned char>& image, unsigned short address, std::vector<unsigned char> bytes) {
+	std::copy(bytes.begin(), bytes.end(), image.begin() + (address & 0x0FFF));
+}
+
+static void branches() {
+	std::vector<unsigned char> image = rom();
+	place(image, 0xF000, { 0xA2, 0x05, 0xE6, 0x80, 0xCA, 0xD0, 0xFB, 0x4C, 0x07, 0xF0 }); //LDX #5, loop: INC $80, DEX, BNE loop, JMP *
+	place(image, 0xF010, { 0xD0, 0xF0 }); //BNE $F002, backwards on the same page
+	place(image, 0xF0F0, { 0xD0, 0x20 }); //BNE $F112, forwards onto the next page
+	place(image, 0xF100, { 0xD0, 0xFA }); //BNE $F0FC, backwards onto the previous page
+	Rig rig(image);
+	rig.mem.write(0x80, 0);
+	rig.cpu.run_cycles(rig.mem, 200);
+	CHECK_EQUAL(5, rig.mem.read(0x80));
+	CHECK_EQUAL(0, rig.cpu.X);
+	CHECK_EQUAL(0xF007, rig.cpu.PC);
+
+	rig.cpu.Z_result = 1; //Z clear, BNE taken
+	CHECK_EQUAL(3, rig.step(0xF010));
+	CHECK_EQUAL(0xF002, rig.cpu.PC);
+	CHECK_EQUAL(4, rig.step(0xF0F0));
+	CHECK_EQUAL(0xF112, rig.cpu.PC);
+	CHECK_EQUAL(4, rig.step(0xF100));
+	CHECK_EQUAL(0xF0FC, rig.cpu.PC);
+	rig.cpu.Z_result = 0; //Z set, not taken
+	CHECK_EQUAL(2, rig.step(0xF0F0));
+	CHECK_EQUAL(0xF0F2, rig.cpu.PC);
+}
+
+static void brk() { //pushes PC + 2 and the flags with B set, then jumps through $FFFE
+	std::vector<unsigned char> image = rom();
+	place(image, 0xF000, { 0x00, 0xEA });
+	image[0xFFE] = 0x00;
+	image[0xFFF] = 0xF3;
+	Rig rig(image);
+	rig.cpu.SP = 0xFF;
+	rig.cpu.I = 0;
+	rig.cpu.V = 0;
+	CHECK_EQUAL(7, rig.step(0xF000));
+	CHECK_EQUAL(0xF300, rig.cpu.PC);
+	CHECK_EQUAL(0xFC, rig.cpu.SP);
+	CHECK(rig.cpu.I);
+	CHECK_EQUAL(0xF0, rig.mem.read(0x1FF));
+	CHECK_EQUAL(0x02, rig.mem.read(0x1FE));
+	CHECK_EQUAL(0x30, rig.mem.read(0x1FD) & 0x34); //break bits set, I was clear
+}
+
+static void bit() { //Z from A AND memory, N and V straight from memory
+	std::vector<unsigned char> image = rom();
+	place(image, 0xF000, { 0x24, 0x80 }); //BIT $80
+	place(image, 0xF010, { 0x2C, 0x81, 0x00 }); //BIT $0081
+	Rig rig(image);
+	rig.mem.write(0x80, 0xC0);
+	rig.cpu.A = 0x01;
+	CHECK_EQUAL(3, rig.step(0xF000));
+	CHECK(rig.cpu.Z());
+	CHECK(rig.cpu.N());
+	CHECK(rig.cpu.V);
+	CHECK_EQUAL(0x01, rig.cpu.A);
+	rig.mem.write(0x81, 0x3F);
+	rig.cpu.A = 0xFF;
+	CHECK_EQUAL(4, rig.step(0xF010));
+	CHECK(!rig.cpu.Z());
+	CHECK(!rig.cpu.N());
+	CHECK(!rig.cpu.V);
+}
+
+static void adc_sbc() { //binary mode, every accumulator, operand and carry
+	std::vector<unsigned char> image = rom();
+	place(image, 0xF000, { 0x65, 0x80 }); //ADC $80
+	place(image, 0xF010, { 0xE5, 0x80 }); //SBC $80
+	Rig rig(image);
+	int mismatches = 0;
+	for (int c = 0; c < 2; c++) {
+		for (int a = 0; a < 256; a++) {
+			for (int b = 0; b < 256; b++) {
+				rig.mem.write(0x80, b);
+				rig.cpu.D = 0;
+				rig.cpu.A = a;
+				rig.cpu.C = c;
+				rig.step(0xF000);
+				int sum = a + b + c;
+				bool v = (~(a ^ b) & (a ^ sum) & 0x80) != 0; //operands agree in sign, the result does not
+				if ((rig.cpu.A != (sum & 0xFF)) || (rig.cpu.C != (sum > 0xFF)) || (rig.cpu.V != v) || (rig.cpu.Z() != ((sum & 0xFF) == 0)) || (rig.cpu.N() != ((sum & 0x80) != 0))) { mismatches++; }
+				rig.cpu.A = a;
+				rig.cpu.C = c;
+				rig.step(0xF010);
+				int difference = a - b - (1 - c);
+				v = ((a ^ b) & (a ^ difference) & 0x80) != 0; //operands differ in sign, the result has the subtrahend's
+				if ((rig.cpu.A != (difference & 0xFF)) || (rig.cpu.C != (difference >= 0)) || (rig.cpu.V != v) || (rig.cpu.Z() != ((difference & 0xFF) == 0)) || (rig.cpu.N() != ((difference & 0x80) != 0))) { mismatches++; }
+			}
+		}
+	}
+	CHECK_EQUAL(0, mismatches);
+	rig.mem.write(0x80, 0x50); //textbook overflow cases
+	rig.cpu.A = 0x50;
+	rig.cpu.C = 0;
+	rig.step(0xF000);
+	CHECK_EQUAL(0xA0, rig.cpu.A);
+	CHECK(rig.cpu.V);
+	rig.mem.write(0x80, 0xB0);
+	rig.cpu.A = 0x50;
+	rig.cpu.C = 1;
+	rig.step(0xF010);
+	CHECK_EQUAL(0xA0, rig.cpu.A);
+	CHECK(rig.cpu.V);
+	CHECK(!rig.cpu.C);
+}
+
+static void rol() { //old carry into bit 0, bit 7 into carry
+	std::vector<unsigned char> image = rom();
+	place(image, 0xF000, { 0x2A }); //ROL A
+	place(image, 0xF010, { 0x26, 0x80 }); //ROL $80
+	Rig rig(image);
+	rig.cpu.A = 0x80;
+	rig.cpu.C = 1;
+	CHECK_EQUAL(2, rig.step(0xF000));
+	CHECK_EQUAL(0x01, rig.cpu.A);
+	CHECK(rig.cpu.C);
+	CHECK(!rig.cpu.Z());
+	rig.cpu.A = 0x80;
+	rig.cpu.C = 0;
+	rig.step(0xF000);
+	CHECK_EQUAL(0x00, rig.cpu.A);
+	CHECK(rig.cpu.C);
+	CHECK(rig.cpu.Z());
+	rig.mem.write(0x80, 0x40);
+	rig.cpu.C = 1;
+	CHECK_EQUAL(5, rig.step(0xF010));
+	CHECK_EQUAL(0x81, rig.mem.read(0x80));
+	CHECK(!rig.cpu.C);
+	CHECK(rig.cpu.N());
+}
+
+static void zero_page_wrap() { //pointers and indexes stay in zero page. $100 mirrors $00 on the 2600 bus, so the values pin where the bytes come from
+	std::vector<unsigned char> image = rom();
+	place(image, 0xF000, { 0xB1, 0xFF }); //LDA ($FF),Y: low byte at $FF, high byte at $00 (TIA, reads 0)
+	place(image, 0xF010, { 0xA1, 0xF0 }); //LDA ($F0,X)
+	place(image, 0xF020, { 0xB5, 0xF0 }); //LDA $F0,X
+	Rig rig(image);
+	rig.mem.write(0x86, 0x5A);
+	rig.mem.write(0xFF, 0x85);
+	rig.cpu.Y = 1;
+	CHECK_EQUAL(5, rig.step(0xF000));
+	CHECK_EQUAL(0x5A, rig.cpu.A);
+	rig.mem.write(0x80, 0x86); //pointer at $F0 + $90 = $80
+	rig.mem.write(0x81, 0x00);
+	rig.cpu.X = 0x90;
+	rig.cpu.A = 0;
+	CHECK_EQUAL(6, rig.step(0xF010));
+	CHECK_EQUAL(0x5A, rig.cpu.A);
+	rig.cpu.X = 0x96; //$F0 + $96 = $86
+	rig.cpu.A = 0;
+	CHECK_EQUAL(4, rig.step(0xF020));
+	CHECK_EQUAL(0x5A, rig.cpu.A);
+}
+
+static void op_table_matches_csv() { //every csv row in the table as written, everything else undocumented
+	static const char* const modes[] = { "IMP", "ACC", "IMM", "ZP", "ZPX", "ZPY", "ABS", "ABSX", "ABSY", "IND", "INDX", "INDY", "REL" }; //AddrMode order
+	std::ifstream csv("6502ops.csv");
+	CHECK(csv.is_open());
+	std::string line;
+	std::getline(csv, line); //header
+	bool documented[256] = {};
+	int rows = 0;
+	while (std::getline(csv, line)) {
+		if (line.empty() || line == "\r") { continue; }
+		std::stringstream fields(line);
+		std::string opcode, mnemonic, mode, bytes, cycles;
+		std::getline(fields, opcode, ',');
+		std::getline(fields, mnemonic, ',');
+		std::getline(fields, mode, ',');
+		std::getline(fields, bytes, ',');
+		std::getline(fields, cycles, ',');
+		int code = std::stoi(opcode, NULL, 16);
+		const OpInfo& op = Processor::op_table[code];
+		CHECK(mnemonic == op.mnemonic);
+		CHECK(mode == modes[(int)op.mode]);
+		CHECK_EQUAL(std::stoi(bytes), op.bytes);
+		CHECK_EQUAL(std::stoi(cycles), op.cycles);
+		CHECK(!documented[code]);
+		documented[code] = 1;
+		rows++;
+	}
+	CHECK_EQUAL(151, rows);
+	for (int code = 0; code < 256; code++) {
+		if (!documented[code]) { CHECK(strcmp(Processor::op_table[code].mnemonic, "???") == 0); }
+	}
+}
+
+void test_cpu() {
+	op_table_matches_csv();
+	branches();
+	brk();
+	bit();
+	adc_sbc();
+	rol();
+	zero_page_wrap();
+}
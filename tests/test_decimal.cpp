@@ -0,0 +1,110 @@
+#include <vector>
+
+#include "check.h"
+#include "../cartridge.h"
+#include "../cpu.h"
+
+// Decimal mode ADC and SBC against a reference written from Bruce Clark's "Decimal Mode" tutorial (appendix A, NMOS
+// 6502), step by step as it gives them, for every accumulator, operand and carry, valid BCD or not. Each case runs
+// through the CPU as a real instruction.
+
+struct Expected {
+	int result;
+	bool N, V, Z, C;
+};
+
+static Expected reference_adc(int a, int b, int c) {
+	Expected e;
+	int al = (a & 0x0F) + (b & 0x0F) + c; //sequence 1: result and carry
+	if (al >= 0x0A) { al = ((al + 0x06) & 0x0F) + 0x10; }
+	int sum = (a & 0xF0) + (b & 0xF0) + al;
+	if (sum >= 0xA0) { sum = sum + 0x60; }
+	e.result = sum & 0xFF;
+	e.C = sum >= 0x100;
+	int signed_sum = (signed char)(a & 0xF0) + (signed char)(b & 0xF0) + al; //sequence 2: N and V, same low digit
+	e.N = signed_sum & 0x80;
+	e.V = (signed_sum < -128) || (signed_sum > 127);
+	e.Z = ((a + b + c) & 0xFF) == 0; //Z is from the binary sum
+	return e;
+}
+
+static Expected reference_sbc(int a, int b, int c) {
+	Expected e;
+	int al = (a & 0x0F) - (b & 0x0F) + c - 1; //sequence 3: result
+	if (al < 0) { al = ((al - 0x06) & 0x0F) - 0x10; }
+	int difference = (a & 0xF0) - (b & 0xF0) + al;
+	if (difference < 0) { difference = difference - 0x60; }
+	e.result = difference & 0xFF;
+	int binary = a - b + c - 1; //the flags are the binary mode ones
+	e.N = binary & 0x80;
+	e.V = ((a ^ b) & (a ^ binary) & 0x80) != 0;
+	e.Z = (binary & 0xFF) == 0;
+	e.C = binary >= 0;
+	return e;
+}
+
+static void sweep(unsigned char opcode, Expected (*reference)(int, int, int)) {
+	std::vector<unsigned char> image(0x1000, 0xEA);
+	image[0] = opcode; //$F000: ADC $80 or SBC $80
+	image[1] = 0x80;
+	image[0xFFC] = 0x00;
+	image[0xFFD] = 0xF0;
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "4K"));
+	Processor cpu(mem);
+	int mismatches = 0;
+	for (int c = 0; c < 2; c++) {
+		for (int a = 0; a < 256; a++) {
+			for (int b = 0; b < 256; b++) {
+				cpu.PC = 0xF000;
+				cpu.D = 1;
+				cpu.C = c;
+				cpu.A = a;
+				mem.write(0x80, b);
+				cpu.run_cycles(mem, 1); //one instruction
+				Expected e = reference(a, b, c);
+				if ((cpu.A != e.result) || (cpu.N() != e.N) || (cpu.V != e.V) || (cpu.Z() != e.Z) || (cpu.C != e.C)) {
+					if (mismatches++ < 8) { //the first few tell enough
+						CHECK_EQUAL(e.result, cpu.A);
+						CHECK_EQUAL(e.N, cpu.N());
+						CHECK_EQUAL(e.V, cpu.V);
+						CHECK_EQUAL(e.Z, cpu.Z());
+						CHECK_EQUAL(e.C, cpu.C);
+						std::cerr << std::hex << "  opcode " << (int)opcode << ", A " << a << ", operand " << b << ", C " << c << std::dec << std::endl;
+					}
+				}
+			}
+		}
+	}
+	CHECK_EQUAL(0, mismatches);
+	CHECK_EQUAL(0xF002, cpu.PC);
+}
+
+static void known_sums() { //textbook cases, in case the reference itself goes wrong
+	Expected e = reference_adc(0x58, 0x46, 1);
+	CHECK_EQUAL(0x05, e.result);
+	CHECK(e.C);
+	e = reference_adc(0x12, 0x34, 0);
+	CHECK_EQUAL(0x46, e.result);
+	CHECK(!e.C);
+	e = reference_adc(0x99, 0x01, 0);
+	CHECK_EQUAL(0x00, e.result);
+	CHECK(e.C);
+	CHECK(!e.Z); //binary sum is $9A
+	e = reference_sbc(0x46, 0x12, 1);
+	CHECK_EQUAL(0x34, e.result);
+	CHECK(e.C);
+	e = reference_sbc(0x40, 0x13, 1);
+	CHECK_EQUAL(0x27, e.result);
+	e = reference_sbc(0x12, 0x21, 1);
+	CHECK_EQUAL(0x91, e.result);
+	CHECK(!e.C);
+	e = reference_sbc(0x00, 0x00, 0);
+	CHECK_EQUAL(0x99, e.result);
+}
+
+void test_decimal() {
+	known_sums();
+	sweep(0x65, &reference_adc);
+	sweep(0xE5, &reference_sbc);
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <vector>
+
+#include "check.h"
+#include "../cartridge.h"
+#include "../cpu.h"
+#include "../snapshot.h"
+
+// Idle loop skipping must not change what the program sees. A frame loop waits on the RIOT timer every way games do
+// (INTIM down to zero, TIMINT, INTIM against a threshold) at all four intervals. It runs with skipping off, on, and on
+// with the JIT: every frame, the clock, the picture and the snapshot must be the same. A skip that goes past the
+// timer's next change (RIOT::next_change) or does not leave the last pass to run for real shows up as a moved clock,
+// and so does one that counts that change from the branch rather than from the reads of the pass before it.
+
+static const unsigned char kernel[] = { //$F000
+	0x78, 0xD8, 0xA2, 0xFF, 0x9A, 0xA9, 0x00, //SEI, CLD, LDX #$FF, TXS, LDA #0
+	0xA9, 0x02, 0x85, 0x01, 0x85, 0x00, //frame: VBLANK and VSYNC on
+	0x85, 0x02, 0x85, 0x02, 0x85, 0x02, 0xA9, 0x00, 0x85, 0x00, //three lines, VSYNC off
+	0xA9, 0x2B, 0x8D, 0x96, 0x02, //LDA #43, STA TIM64T
+	0xAD, 0x84, 0x02, 0xD0, 0xFB, //LDA INTIM, BNE back
+	0xA9, 0x00, 0x85, 0x01, //VBLANK off
+	0xA9, 0x1E, 0x8D, 0x95, 0x02, //LDA #30, STA TIM8T
+	0x2C, 0x85, 0x02, 0x10, 0xFB, //BIT TIMINT, BPL back
+	0xA2, 0xB4, 0x86, 0x09, 0x85, 0x02, 0xCA, 0xD0, 0xF9, //LDX #180, line: STX COLUBK, STA WSYNC, DEX, BNE line
+	0xA9, 0x50, 0x8D, 0x94, 0x02, //LDA #80, STA TIM1T
+	0xAD, 0x84, 0x02, 0xC9, 0x20, 0xB0, 0xF9, //LDA INTIM, CMP #$20, BCS back
+	0xA9, 0x03, 0x8D, 0x97, 0x02, //LDA #3, STA T1024T
+	0xAD, 0x84, 0x02, 0xC9, 0x01, 0xB0, 0xF9, //LDA INTIM, CMP #1, BCS back
+	0x2C, 0x85, 0x02, 0x10, 0xFB, //BIT TIMINT, BPL back
+	0xE6, 0x80, 0x4C, 0x07, 0xF0, //INC $80, JMP frame
+};
+
+struct Console {
+	std::vector<unsigned char> image;
+	MemIO mem;
+	Processor cpu;
+	Console(bool idle_skip, bool jit) : image(0x1000, 0xEA), mem(0x10000, "colors.csv", 228, 262), cpu(mem) {
+		std::copy(kernel, kernel + sizeof(kernel), image.begin());
+		image[0xFFC] = 0x00;
+		image[0xFFD] = 0xF0;
+		mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "4K"));
+		cpu.reset(mem);
+		cpu.set_idle_skip(idle_skip);
+		cpu.set_jit(jit);
+	}
+	std::vector<unsigned char> state() const {
+		std::vector<unsigned char> snapshot(snapshot_size(mem));
+		save_snapshot(cpu, mem, snapshot.data(), (int)snapshot.size());
+		return snapshot;
+	}
+	std::vector<unsigned char> picture() const {
+		const unsigned char* front = mem.frame.front();
+		return std::vector<unsigned char>(front, front + mem.frame.height * mem.frame.stride);
+	}
+};
+
+static void same(const Console& reference, const Console& other) {
+	CHECK_EQUAL(reference.mem.cycles, other.mem.cycles);
+	CHECK(reference.state() == other.state());
+	CHECK(reference.picture() == other.picture());
+}
+
+void test_idle() {
+	Console plain(0, 0);
+	Console skipping(1, 0);
+	Console native(1, 1);
+	for (int frame = 0; frame < 12; frame++) {
+		CHECK(plain.cpu.run_until_frame(plain.mem));
+		CHECK(skipping.cpu.run_until_frame(skipping.mem));
+		CHECK(native.cpu.run_until_frame(native.mem));
+		same(plain, skipping);
+		same(plain, native);
+	}
+	CHECK_EQUAL(12, plain.mem.read(0x80) + 1); //the first VSYNC comes before any INC
+	unsigned int seed = 7;
+	for (int i = 0; i < 60; i++) { //budgets that end anywhere, in the middle of a wait too
+		seed = seed * 1103515245 + 12345;
+		unsigned long long budget = 1 + (seed >> 16) % 3000;
+		unsigned long long ran = plain.cpu.run_cycles(plain.mem, budget);
+		CHECK_EQUAL(ran, skipping.cpu.run_cycles(skipping.mem, budget));
+		CHECK_EQUAL(ran, native.cpu.run_cycles(native.mem, budget));
+		same(plain, skipping);
+		same(plain, native);
+	}
+}
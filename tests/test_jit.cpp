@@ -0,0 +1,107 @@
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "../cartridge.h"
+#include "../cpu.h"
+#include "../snapshot.h"
+
+// JIT lockstep. Random programs run on two machines, one interpreting and one with the JIT on. Both get the same
+// cycle budgets and after every run_cycles they must have run the same cycles and be in the same state, snapshot
+// for snapshot. Where there is no JIT both machines interpret and the test passes trivially.
+
+static const char* const translated[] = { "LDA", "LDX", "LDY", "STA", "STX", "STY", "AND", "ORA", "EOR", "CMP", "CPX", "CPY",
+	"ADC", "SBC", "BIT", "INC", "DEC", "INX", "INY", "DEX", "DEY", "ASL", "LSR", "ROL", "ROR", "TAX", "TAY", "TXA", "TYA",
+	"TSX", "CLC", "SEC", "CLV", "CLD", "NOP" };
+
+static unsigned int next_random(unsigned int& seed) { //fixed sequence, the same on every run
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static bool pick(int opcode, unsigned int& seed) { //mostly instructions the JIT translates, now and then one it leaves to the interpreter
+	for (const char* mnemonic : translated) {
+		if (!strcmp(Processor::op_table[opcode].mnemonic, mnemonic)) { return 1; }
+	}
+	bool rare = (opcode == 0x48) || (opcode == 0x68) || (opcode == 0xF8) || (opcode == 0x10) || (opcode == 0xB0); //PHA, PLA, SED, BPL, BCS
+	return rare && (next_random(seed) % 40 == 0);
+}
+
+static std::vector<unsigned char> random_program(unsigned int& seed) { //at $F000, short enough to loop well past JitCache::JIT_THRESHOLD
+	std::vector<unsigned char> image(0x1000);
+	for (unsigned char& byte : image) { byte = (unsigned char)next_random(seed); } //data for the absolute reads
+	int pc = 0;
+	while (pc < 0x200) {
+		int opcode;
+		do { opcode = next_random(seed) & 0xFF; } while (!pick(opcode, seed));
+		image[pc++] = opcode;
+		int address;
+		switch (Processor::op_table[opcode].mode) {
+		case AddrMode::IMM: image[pc++] = next_random(seed); break;
+		case AddrMode::REL: image[pc++] = 2 + next_random(seed) % 16; break; //forward only, maybe into the middle of an instruction
+		case AddrMode::ZP:
+		case AddrMode::ZPX:
+		case AddrMode::ZPY: //RAM, sometimes the TIA
+			image[pc++] = (next_random(seed) % 10 == 0) ? next_random(seed) % 0x40 : 0x80 + next_random(seed) % 0x80;
+			break;
+		case AddrMode::ABS:
+		case AddrMode::ABSX:
+		case AddrMode::ABSY: //RAM or ROM, stores to ROM are dropped
+			address = (next_random(seed) % 3 == 0) ? 0x80 + next_random(seed) % 0x80 : 0xF000 + next_random(seed) % 0xF00;
+			image[pc++] = address & 0xFF;
+			image[pc++] = address >> 8;
+			break;
+		case AddrMode::INDX:
+		case AddrMode::INDY: image[pc++] = 0x80 + next_random(seed) % 0x7F; break;
+		default: break;
+		}
+	}
+	image[pc++] = 0x4C; //JMP $F000
+	image[pc++] = 0x00;
+	image[pc++] = 0xF0;
+	image[0xFFC] = 0x00;
+	image[0xFFD] = 0xF0;
+	return image;
+}
+
+static std::vector<unsigned char> state(const Processor& cpu, const MemIO& mem) {
+	std::vector<unsigned char> snapshot(snapshot_size(mem));
+	save_snapshot(cpu, mem, snapshot.data(), (int)snapshot.size());
+	return snapshot;
+}
+
+static void lockstep(unsigned int program) {
+	unsigned int seed = program;
+	std::vector<unsigned char> image = random_program(seed);
+	MemIO mem_a(0x10000, "colors.csv", 228, 262);
+	MemIO mem_b(0x10000, "colors.csv", 228, 262);
+	mem_a.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "4K"));
+	mem_b.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "4K"));
+	Processor cpu_a(mem_a);
+	Processor cpu_b(mem_b);
+	cpu_b.set_jit(1);
+	for (int i = 0; i < 128; i++) { //same random RAM and registers for both
+		unsigned char value = next_random(seed);
+		mem_a.write(0x80 + i, value);
+		mem_b.write(0x80 + i, value);
+	}
+	cpu_a.A = cpu_b.A = next_random(seed);
+	cpu_a.X = cpu_b.X = next_random(seed);
+	cpu_a.Y = cpu_b.Y = next_random(seed);
+	for (int batch = 0; batch < 600; batch++) {
+		unsigned long long budget = 1 + next_random(seed) % 300;
+		unsigned long long ran_a = cpu_a.run_cycles(mem_a, budget);
+		unsigned long long ran_b = cpu_b.run_cycles(mem_b, budget);
+		if ((ran_a != ran_b) || (state(cpu_a, mem_a) != state(cpu_b, mem_b))) { //report the first divergence only
+			CHECK_EQUAL(ran_a, ran_b);
+			CHECK(state(cpu_a, mem_a) == state(cpu_b, mem_b));
+			std::cerr << "program " << program << " diverged in batch " << batch << ", PC " << std::hex << cpu_a.PC << "/" << cpu_b.PC << std::dec << std::endl;
+			return;
+		}
+	}
+	CHECK(state(cpu_a, mem_a) == state(cpu_b, mem_b));
+}
+
+void test_jit() {
+	for (unsigned int program = 1; program <= 40; program++) { lockstep(program); }
+}
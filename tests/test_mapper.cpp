@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <vector>
+
+#include "check.h"
+#include "../cartridge.h"
+#include "../cpu.h"
+
+// Bank-switching sequences for every mapper. Images are tagged: the first two bytes of each 64-byte page hold its
+// offset in the image, so reading them back through the bus tells which part of the ROM a page shows.
+
+static std::vector<unsigned char> tagged_image(int size) {
+	std::vector<unsigned char> image(size, 0xEA);
+	for (int offset = 0; offset < size; offset += 64) {
+		image[offset] = (offset >> 6) & 0xFF;
+		image[offset + 1] = offset >> 14;
+	}
+	return image;
+}
+
+static int shown(MemIO& mem, unsigned short address) { //image offset seen at a page aligned address
+	return (mem.read(address) | (mem.read(address + 1) << 8)) << 6;
+}
+
+static void f8_family(const char* scheme, int banks, unsigned short first_hotspot, int start_bank) {
+	std::vector<unsigned char> image = tagged_image(banks * 0x1000);
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), scheme));
+	CHECK_EQUAL(start_bank * 0x1000, shown(mem, 0x1000));
+	for (int bank = banks - 1; bank >= 0; bank--) {
+		mem.read(first_hotspot + bank);
+		CHECK_EQUAL(bank * 0x1000, shown(mem, 0x1000));
+		CHECK_EQUAL(bank * 0x1000 + 0x800, shown(mem, 0x1800));
+		CHECK_EQUAL(bank * 0x1000 + 0xFC0, shown(mem, 0x1FC0)); //hooked page, read through the cartridge
+	}
+	mem.write(first_hotspot + banks - 1, 0); //writes switch too
+	CHECK_EQUAL((banks - 1) * 0x1000, shown(mem, 0x1000));
+	mem.read(first_hotspot - 1); //just below the hotspots, nothing happens
+	CHECK_EQUAL((banks - 1) * 0x1000, shown(mem, 0x1000));
+	mem.read(0xF000 | (first_hotspot & 0x0FFF)); //13-bit mirror
+	CHECK_EQUAL(0, shown(mem, 0x1000));
+}
+
+static void superchip() { //F8SC: 128 bytes of RAM, written at $1000-$107F, read back at $1080-$10FF
+	std::vector<unsigned char> image = tagged_image(0x2000);
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "F8SC"));
+	mem.write(0x1005, 0x77);
+	mem.write(0x107F, 0x12);
+	CHECK_EQUAL(0x77, mem.read(0x1085));
+	CHECK_EQUAL(0x12, mem.read(0x10FF));
+	mem.read(0x1FF8);
+	CHECK_EQUAL(0x77, mem.read(0x1085)); //the RAM does not bank
+	CHECK_EQUAL(0x100, shown(mem, 0x1100)); //ROM above it does
+	mem.write(0x1085, 0x00); //read port, the write is dropped
+	CHECK_EQUAL(0x77, mem.read(0x1085));
+}
+
+static void e0() {
+	std::vector<unsigned char> image = tagged_image(0x2000);
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "E0"));
+	CHECK_EQUAL(4 * 0x400, shown(mem, 0x1000));
+	CHECK_EQUAL(5 * 0x400, shown(mem, 0x1400));
+	CHECK_EQUAL(6 * 0x400, shown(mem, 0x1800));
+	CHECK_EQUAL(7 * 0x400, shown(mem, 0x1C00));
+	mem.read(0x1FE3); //segment 0, slice 3
+	mem.read(0x1FEA); //segment 1, slice 2
+	mem.write(0x1FF1, 0); //segment 2, slice 1
+	CHECK_EQUAL(3 * 0x400, shown(mem, 0x1000));
+	CHECK_EQUAL(3 * 0x400 + 0x3C0, shown(mem, 0x13C0));
+	CHECK_EQUAL(2 * 0x400, shown(mem, 0x1400));
+	CHECK_EQUAL(1 * 0x400, shown(mem, 0x1800));
+	CHECK_EQUAL(7 * 0x400, shown(mem, 0x1C00)); //last slice is fixed
+	mem.read(0x1FE7);
+	CHECK_EQUAL(7 * 0x400, shown(mem, 0x1000));
+	CHECK_EQUAL(2 * 0x400, shown(mem, 0x1400));
+}
+
+static void tigervision() { //3F: writes to $3F pick the lower 2K, the upper 2K is the last bank
+	std::vector<unsigned char> image = tagged_image(0x2000);
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "3F"));
+	CHECK_EQUAL(0, shown(mem, 0x1000));
+	CHECK_EQUAL(3 * 0x800, shown(mem, 0x1800));
+	mem.write(0x3F, 2);
+	CHECK_EQUAL(2 * 0x800, shown(mem, 0x1000));
+	CHECK_EQUAL(2 * 0x800 + 0x7C0, shown(mem, 0x17C0));
+	mem.write(0x09, 1); //COLUBK, an ordinary TIA write
+	CHECK_EQUAL(2 * 0x800, shown(mem, 0x1000));
+	mem.write(0x3F, 5); //wraps on the bank count
+	CHECK_EQUAL(1 * 0x800, shown(mem, 0x1000));
+	CHECK_EQUAL(3 * 0x800, shown(mem, 0x1800));
+}
+
+static void m_network() { //E7: 2K ROM banks or 1K of RAM low, a 256-byte RAM window and a fixed top
+	std::vector<unsigned char> image = tagged_image(0x4000);
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "E7"));
+	const int fixed = 7 * 0x800 + 0x200;
+	CHECK_EQUAL(0, shown(mem, 0x1000));
+	CHECK_EQUAL(fixed, shown(mem, 0x1A00));
+	mem.read(0x1FE3);
+	CHECK_EQUAL(3 * 0x800, shown(mem, 0x1000));
+	CHECK_EQUAL(3 * 0x800 + 0x400, shown(mem, 0x1400));
+	mem.read(0x1FE7); //1K RAM: write $1000-$13FF, read $1400-$17FF
+	mem.write(0x1005, 0x5A);
+	mem.write(0x13FF, 0xA5);
+	CHECK_EQUAL(0x5A, mem.read(0x1405));
+	CHECK_EQUAL(0xA5, mem.read(0x17FF));
+	mem.read(0x1FE9); //window bank 1: write $1800-$18FF, read $1900-$19FF
+	mem.write(0x1810, 0x66);
+	CHECK_EQUAL(0x66, mem.read(0x1910));
+	mem.read(0x1FE8);
+	CHECK_EQUAL(0x00, mem.read(0x1910));
+	mem.read(0x1FE9);
+	CHECK_EQUAL(0x66, mem.read(0x1910));
+	mem.read(0x1FE0);
+	CHECK_EQUAL(0, shown(mem, 0x1000));
+	mem.read(0x1FE7);
+	CHECK_EQUAL(0x5A, mem.read(0x1405)); //RAM kept its contents while ROM was shown
+	CHECK_EQUAL(fixed, shown(mem, 0x1A00));
+	CHECK_EQUAL(fixed + 0x5C0, shown(mem, 0x1FC0));
+}
+
+static void dpc() { //F8 banking, data fetchers and the random number generator
+	std::vector<unsigned char> image = tagged_image(0x2000 + 0x800);
+	for (int i = 0; i < 0x800; i++) { image[0x2000 + i] = i & 0xFF; } //display ROM
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "DPC"));
+	CHECK_EQUAL(0x1100, shown(mem, 0x1100));
+	mem.read(0x1FF8);
+	CHECK_EQUAL(0x100, shown(mem, 0x1100));
+	mem.write(0x1050, 0x10); //fetcher 0 counter, low byte
+	mem.write(0x1058, 0x00); //high bits
+	CHECK_EQUAL(0xEF, mem.read(0x1008)); //display data at $7FF - counter, the counter then counts down
+	CHECK_EQUAL(0xF0, mem.read(0x1008));
+	CHECK_EQUAL(0xF1, mem.read(0x1008));
+	mem.write(0x1070, 0); //reset the generator
+	unsigned char first = mem.read(0x1000);
+	int period = 0;
+	for (int i = 1; i <= 300; i++) {
+		if (mem.read(0x1000) == first) { period = i; break; }
+	}
+	CHECK_EQUAL(255, period);
+}
+
+static void fe() { //bank follows the high byte of JSR targets and RTS return addresses: $Fxxx bank 0, $Dxxx bank 1
+	std::vector<unsigned char> image(0x2000, 0xEA);
+	static const unsigned char main_loop[] = { //$F000, bank 0
+		0xA2, 0xFF, 0x9A, //LDX #$FF, TXS
+		0x20, 0x00, 0xD1, //JSR $D100, into bank 1
+		0xE6, 0x80, //INC $80
+		0x20, 0x00, 0xF2, //JSR $F200, stays in bank 0
+		0xE6, 0x81, //INC $81
+		0x4C, 0x03, 0xF0, //JMP $F003
+	};
+	static const unsigned char bank0_sub[] = { 0xE6, 0x82, 0x60 }; //$F200: INC $82, RTS
+	static const unsigned char bank1_sub[] = { 0xE6, 0x83, 0x20, 0x00, 0xD2, 0x60 }; //$D100: INC $83, JSR $D200, RTS
+	static const unsigned char bank1_inner[] = { 0xE6, 0x84, 0x60 }; //$D200: INC $84, RTS
+	std::copy(main_loop, main_loop + sizeof(main_loop), image.begin());
+	std::copy(bank0_sub, bank0_sub + sizeof(bank0_sub), image.begin() + 0x200);
+	std::copy(bank1_sub, bank1_sub + sizeof(bank1_sub), image.begin() + 0x1100);
+	std::copy(bank1_inner, bank1_inner + sizeof(bank1_inner), image.begin() + 0x1200);
+	image[0x0FFC] = 0x00; //reset vector, bank 0
+	image[0x0FFD] = 0xF0;
+	for (int jit = 0; jit < 2; jit++) {
+		MemIO mem(0x10000, "colors.csv", 228, 262);
+		mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "FE"));
+		Processor cpu(mem);
+		cpu.set_jit(jit);
+		cpu.run_cycles(mem, 8000);
+		int calls = mem.read(0x84);
+		CHECK(calls > 100);
+		CHECK(mem.read(0x83) == calls);
+		CHECK((mem.read(0x80) == calls) || (mem.read(0x80) == calls - 1));
+		CHECK((mem.read(0x82) == mem.read(0x80)) || (mem.read(0x82) == mem.read(0x80) + 1));
+		CHECK((mem.read(0x81) == mem.read(0x82)) || (mem.read(0x81) == mem.read(0x82) - 1));
+	}
+}
+
+static void bank_switched_code() { //code keeps running across switches, from the bank just selected (decode caches and JIT)
+	std::vector<unsigned char> image(0x2000, 0xEA);
+	static const unsigned char bank0[] = { //$1F00
+		0xA9, 0x00, 0x85, 0x80, //LDA #0, STA $80
+		0xE6, 0x81, //INC $81
+		0xAD, 0xF9, 0x1F, //LDA $1FF9, bank 1 goes on at $1F09
+	};
+	static const unsigned char bank1[] = { //$1F09
+		0xA9, 0x01, 0x85, 0x80, //LDA #1, STA $80
+		0xE6, 0x82, //INC $82
+		0xAD, 0xF8, 0x1F, //LDA $1FF8, bank 0 goes on at $1F12
+	};
+	static const unsigned char bank0_back[] = { 0x4C, 0x00, 0x1F }; //$1F12: JMP $1F00
+	std::copy(bank0, bank0 + sizeof(bank0), image.begin() + 0xF00);
+	std::copy(bank1, bank1 + sizeof(bank1), image.begin() + 0x1F09);
+	std::copy(bank0_back, bank0_back + sizeof(bank0_back), image.begin() + 0xF12);
+	image[0x1FFC] = 0x00; //F8 starts in bank 1
+	image[0x1FFD] = 0x1F;
+	image[0x1F00] = 0x4C; //bank 1 $1F00: JMP $1F06, the LDA $1FF9 there
+	image[0x1F01] = 0x06;
+	image[0x1F02] = 0x1F;
+	image[0x1F06] = 0xAD;
+	image[0x1F07] = 0xF8;
+	image[0x1F08] = 0x1F;
+	for (int jit = 0; jit < 2; jit++) {
+		MemIO mem(0x10000, "colors.csv", 228, 262);
+		mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), "F8"));
+		Processor cpu(mem);
+		cpu.set_jit(jit);
+		cpu.run_cycles(mem, 30000);
+		int passes = mem.read(0x81);
+		CHECK(passes > 0);
+		CHECK((mem.read(0x82) == passes) || (mem.read(0x82) == passes - 1));
+		for (int i = 0; i < 1000; i++) { cpu.cpu_tick(mem); }
+		CHECK(mem.read(0x81) != passes);
+	}
+}
+
+void test_mapper() {
+	f8_family("F8", 2, 0x1FF8, 1);
+	f8_family("F6", 4, 0x1FF6, 0);
+	f8_family("F4", 8, 0x1FF4, 0);
+	superchip();
+	e0();
+	tigervision();
+	m_network();
+	dpc();
+	fe();
+	bank_switched_code();
+}
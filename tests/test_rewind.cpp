@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <vector>
+
+#include "check.h"
+#include "../cartridge.h"
+#include "../cpu.h"
+#include "../rewind.h"
+#include "../snapshot.h"
+
+// Rewind history: the RLE XOR codec round trips whatever it is given, and every frame still held comes back as the
+// exact snapshot it was recorded from, whether it was a keyframe or a delta and however much the ring has wrapped.
+
+static unsigned int next_random(unsigned int& seed) { //fixed sequence, the same on every run
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static void codec_case(const std::vector<unsigned char>& state, const std::vector<unsigned char>& key) {
+	int size = (int)state.size();
+	std::vector<unsigned char> coded(size + size / 64 + 8);
+	std::vector<unsigned char> decoded(size + 1, 0xA5);
+	int coded_size = rle_xor_encode(state.data(), key.data(), size, coded.data());
+	CHECK(coded_size <= size + size / 64 + 8);
+	rle_xor_decode(coded.data(), coded_size, key.data(), size, decoded.data());
+	CHECK(std::equal(state.begin(), state.end(), decoded.begin()));
+	CHECK_EQUAL(0xA5, decoded[size]); //nothing past the end
+}
+
+static void codec() {
+	const int sizes[] = { 0, 1, 2, 3, 7, 8, 9, 130, 5000 };
+	unsigned int seed = 1;
+	for (int size : sizes) {
+		std::vector<unsigned char> key(size);
+		for (int i = 0; i < size; i++) { key[i] = (unsigned char)next_random(seed); }
+		std::vector<unsigned char> state = key;
+		codec_case(state, key); //unchanged
+		for (int i = 0; i < size; i++) { state[i] = key[i] ^ 0xFF; }
+		codec_case(state, key); //all changed
+		for (int gap = 1; gap <= 4; gap++) { //literal runs broken by short equal runs, around the 3 byte cut
+			for (int i = 0; i < size; i++) { state[i] = (i % (gap + 1) == 0) ? (key[i] ^ 1) : key[i]; }
+			codec_case(state, key);
+		}
+		if (size == 0) { continue; }
+		state = key; //a few bytes moved, the way frames differ
+		for (int i = 0; i < size / 50 + 1; i++) { state[next_random(seed) % size] ^= 0x10; }
+		state[size - 1] ^= 0x80;
+		codec_case(state, key);
+		std::vector<unsigned char> garbage(size / 3 + 4); //not a delta at all, decoding stays inside state
+		for (unsigned char& byte : garbage) { byte = (unsigned char)next_random(seed); }
+		garbage.back() = 0x80; //ends inside a varint
+		std::vector<unsigned char> decoded(size + 1, 0xA5);
+		rle_xor_decode(garbage.data(), (int)garbage.size(), key.data(), size, decoded.data());
+		std::fill(garbage.begin(), garbage.end() - 1, 0xFF); //runs far longer than state
+		rle_xor_decode(garbage.data(), (int)garbage.size(), key.data(), size, decoded.data());
+		CHECK_EQUAL(0xA5, decoded[size]);
+	}
+}
+
+static const unsigned char busy_loop[] = { //$F200, clear of Superchip RAM: touches a little of RAM and the RIOT timer on every pass
+	0xA2, 0xFF, 0x9A, //LDX #$FF, TXS
+	0xE6, 0x80, //loop: INC $80
+	0xA5, 0x80, 0x29, 0x3F, 0xAA, //LDA $80, AND #$3F, TAX
+	0xF6, 0x81, //INC $81,X
+	0x8D, 0x96, 0x02, //STA TIM64T
+	0x4C, 0x03, 0xF2, //JMP loop
+};
+
+struct Machine {
+	std::vector<unsigned char> image;
+	MemIO mem;
+	Processor cpu;
+	Machine() : mem(0x10000, "colors.csv", 228, 262), cpu(mem) { insert("4K", 0x1000); }
+	void insert(const char* scheme, int size) { //the same loop in every bank
+		image.assign(size, 0xEA);
+		for (int chunk = 0; chunk < size; chunk += 0x1000) {
+			std::copy(busy_loop, busy_loop + sizeof(busy_loop), image.begin() + chunk + 0x200);
+			image[chunk + 0xFFC] = 0x00;
+			image[chunk + 0xFFD] = 0xF2;
+		}
+		mem.insert_cartridge(Cartridge::create(image.data(), (int)image.size(), scheme));
+		cpu.reset(mem);
+	}
+	std::vector<unsigned char> frame() { //run a little and return the snapshot to record
+		cpu.run_cycles(mem, 997);
+		return current();
+	}
+	std::vector<unsigned char> current() {
+		std::vector<unsigned char> snapshot(snapshot_size(mem));
+		save_snapshot(cpu, mem, snapshot.data(), (int)snapshot.size());
+		return snapshot;
+	}
+};
+
+static void history() { //plenty of room, keyframes and deltas mixed, rewinding then recording on
+	Machine m;
+	RewindBuffer rewind(64, 1 << 20, 7);
+	std::vector<std::vector<unsigned char>> recorded;
+	for (int i = 0; i < 40; i++) {
+		recorded.push_back(m.frame());
+		rewind.record(m.cpu, m.mem);
+	}
+	CHECK_EQUAL(40, rewind.frames_stored());
+	CHECK(rewind.bytes_used() < 40 * (int)recorded[0].size()); //the deltas are smaller than the frames
+	CHECK(rewind.rewind(m.cpu, m.mem, 8)); //behind the latest keyframe, deltas go on against the one before
+	CHECK(m.current() == recorded[31]);
+	CHECK_EQUAL(32, rewind.frames_stored());
+	recorded.resize(32);
+	m.mem.write(0xF0, 0x42); //new history from the restored frame on, not a replay of the dropped one
+	for (int i = 0; i < 20; i++) {
+		recorded.push_back(m.frame());
+		rewind.record(m.cpu, m.mem);
+	}
+	CHECK_EQUAL(52, rewind.frames_stored());
+	CHECK(!rewind.rewind(m.cpu, m.mem, 52));
+	CHECK(!rewind.rewind(m.cpu, m.mem, -1));
+	for (int back : { 0, 3, 1, 9, 0, 5, 17 }) {
+		int target = rewind.frames_stored() - 1 - back;
+		CHECK(rewind.rewind(m.cpu, m.mem, back));
+		CHECK(m.current() == recorded[target]);
+	}
+}
+
+static void wrapped(int max_frames, int arena_frames, int keyframe_interval, int swap_at = -1) { //the ring drops the oldest frames, the rest stay exact
+	Machine m;
+	int state_size = snapshot_size(m.mem);
+	RewindBuffer rewind(max_frames, arena_frames * state_size, keyframe_interval);
+	std::vector<std::vector<unsigned char>> recorded;
+	for (int i = 0; i < 300; i++) {
+		if (i == swap_at) { m.insert("F6SC", 0x4000); } //bigger snapshots from here on
+		recorded.push_back(m.frame());
+		rewind.record(m.cpu, m.mem);
+		CHECK(rewind.frames_stored() <= max_frames);
+		CHECK(rewind.bytes_used() <= arena_frames * state_size);
+	}
+	int stored = rewind.frames_stored();
+	CHECK(stored > 0);
+	CHECK(rewind.rewind(m.cpu, m.mem, 0));
+	CHECK(m.current() == recorded.back());
+	for (int back = 1; back < stored; back++) { //step back one frame at a time down to the oldest
+		const std::vector<unsigned char>& target = recorded[recorded.size() - 1 - back];
+		if (target.size() != recorded.back().size()) { //taken with the other cartridge, refused
+			CHECK(!rewind.rewind(m.cpu, m.mem, 1));
+			CHECK(m.current() == recorded[recorded.size() - back]);
+			return;
+		}
+		CHECK(rewind.rewind(m.cpu, m.mem, 1));
+		CHECK(m.current() == target);
+	}
+	CHECK_EQUAL(1, rewind.frames_stored());
+	CHECK(!rewind.rewind(m.cpu, m.mem, 1));
+}
+
+void test_rewind() {
+	codec();
+	history();
+	wrapped(20, 1000, 5); //frame slots run out first
+	wrapped(1000, 4, 8); //arena runs out first
+	wrapped(1000, 3, 1000); //keyframes dropped with their deltas
+	wrapped(1000, 3, 1, 152); //cartridge swapped, bigger frames no longer fit where the last lap left off
+	wrapped(1000, 3, 3, 173);
+	wrapped(1000, 4, 1, 292);
+}
@@ -0,0 +1,96 @@
+#include "check.h"
+#include "../memory.h"
+#include "../riot.h"
+
+// RIOT interval timer against a timer stepped one cycle at a time, the way the 6532 data sheet describes it: the
+// first decrement comes one cycle after the write, then one per interval, and past zero the counter wraps to $FF,
+// raises TIMINT and counts down once per cycle. The RIOT under test never ticks, it works everything out on read.
+
+struct TickedTimer {
+	int value;
+	int interval;
+	int prescaler;
+	bool underflowed;
+	bool flag;
+	void write(int value, int shift) {
+		this->value = value;
+		interval = 1 << shift;
+		prescaler = 1; //decrements on the next cycle
+		underflowed = 0;
+		flag = 0;
+	}
+	void tick() {
+		if (underflowed) { value = (value - 1) & 0xFF; return; }
+		prescaler = prescaler - 1;
+		if (prescaler > 0) { return; }
+		prescaler = interval;
+		if (value == 0) {
+			value = 0xFF;
+			underflowed = 1;
+			flag = 1;
+		}
+		else { value = value - 1; }
+	}
+};
+
+static const unsigned short TIM1T = 0x294; //TIM8T, TIM64T and T1024T follow
+static const int SHIFTS[4] = { 0, 3, 6, 10 };
+
+static void timer_run(int select, int value) { //every cycle from the write to well past the underflow
+	const unsigned long long start = 1000;
+	RIOT riot;
+	TickedTimer reference;
+	riot.write(TIM1T + select, value, start);
+	reference.write(value, SHIFTS[select]);
+	unsigned long long end = start + 1 + ((unsigned long long)value << SHIFTS[select]) + 600;
+	int mismatches = 0;
+	for (unsigned long long cycle = start; cycle < end; cycle++) {
+		if (cycle > start) { reference.tick(); }
+		RIOT probe = riot; //INTIM reads clear TIMINT, look at a copy
+		if ((probe.INTIM(cycle) != reference.value) || (riot.TIMINT(cycle) != (reference.flag ? 0x80 : 0x00))) { mismatches++; }
+		unsigned long long next = riot.next_change(cycle);
+		RIOT later = riot;
+		if (next <= cycle) { mismatches++; }
+		else if ((later.INTIM(next) == probe.INTIM(cycle)) && (later.TIMINT(next) == riot.TIMINT(cycle))) { mismatches++; } //next_change must be a change
+		if ((next > cycle + 1) && (RIOT(riot).INTIM(next - 1) != probe.INTIM(cycle))) { mismatches++; } //and nothing changes before it
+	}
+	CHECK_EQUAL(0, mismatches);
+}
+
+static void timint_clear() { //reading INTIM after the underflow clears TIMINT until the next write
+	RIOT riot;
+	riot.write(TIM1T + 2, 2, 0); //TIM64T, underflow at 1 + 2 * 64
+	CHECK_EQUAL(0x00, riot.TIMINT(128));
+	CHECK_EQUAL(0x80, riot.TIMINT(129));
+	CHECK_EQUAL(0x80, riot.TIMINT(200)); //TIMINT reads leave it set
+	CHECK_EQUAL(0xFF - (200 - 129), riot.INTIM(200));
+	CHECK_EQUAL(0x00, riot.TIMINT(201));
+	riot.write(TIM1T, 0, 300);
+	CHECK_EQUAL(0x00, riot.TIMINT(300));
+	CHECK_EQUAL(0x80, riot.TIMINT(301));
+}
+
+static void timer_on_the_bus() { //TIM64T write and INTIM read through MemIO, mirrors included
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.cycles = 500;
+	mem.write(0x296, 10);
+	mem.cycles = 500 + 1 + 5 * 64; //sixth decrement
+	CHECK_EQUAL(4, mem.read(0x284));
+	CHECK_EQUAL(4, mem.read(0x0A84));
+	CHECK_EQUAL(0x00, mem.read(0x285));
+	mem.cycles = 500 + 1 + 10 * 64;
+	CHECK_EQUAL(0x80, mem.read(0x285));
+	CHECK_EQUAL(0xFF, mem.read(0x284));
+}
+
+void test_riot() {
+	static const int values[] = { 0, 1, 2, 0x2B, 0xFF };
+	for (int select = 0; select < 4; select++) {
+		for (int value : values) {
+			if ((select == 3) && (value > 2)) { continue; } //T1024T, long enough with the small ones
+			timer_run(select, value);
+		}
+	}
+	timint_clear();
+	timer_on_the_bus();
+}
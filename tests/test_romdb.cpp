@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "../romdb.h"
+
+// ROM identification: the digest, the order of the embedded table, and a table row winning over the signature scan.
+
+static void digests() { //RFC 1321 test suite
+	const char* abc = "abc";
+	const char* message = "message digest";
+	const char* digits = "12345678901234567890123456789012345678901234567890123456789012345678901234567890";
+	CHECK(md5_hex((const unsigned char*)"", 0) == "d41d8cd98f00b204e9800998ecf8427e");
+	CHECK(md5_hex((const unsigned char*)abc, (int)strlen(abc)) == "900150983cd24fb0d6963f7d28e17f72");
+	CHECK(md5_hex((const unsigned char*)message, (int)strlen(message)) == "f96b697d7cb7938d525a2f31aaf161d0");
+	CHECK(md5_hex((const unsigned char*)digits, (int)strlen(digits)) == "57edf4a22be3c955ac49da2e2107b67a"); //two padding blocks
+}
+
+static bool valid_digest(const char* md5) {
+	if (strlen(md5) != 32) { return 0; }
+	for (int i = 0; i < 32; i++) {
+		if (!((md5[i] >= '0' && md5[i] <= '9') || (md5[i] >= 'a' && md5[i] <= 'f'))) { return 0; }
+	}
+	return 1;
+}
+
+static void embedded_table() { //binary search needs strictly sorted lowercase digests
+	int count;
+	const RomEntry* table = rom_database(count);
+	for (int i = 0; i < count; i++) {
+		CHECK(valid_digest(table[i].md5));
+		CHECK(table[i].scheme[0] != 0);
+		if (i > 0) { CHECK(strcmp(table[i - 1].md5, table[i].md5) < 0); }
+		CHECK(find_rom(table[i].md5, table, count) == &table[i]);
+	}
+}
+
+static void table_wins() {
+	std::vector<unsigned char> image(0x2000, 0xEA); //plain 8K, the scan says F8
+	image[0x10] = 0x01; //not blank where Superchip RAM would be
+	std::string md5 = md5_hex(image.data(), (int)image.size());
+	RomInfo scanned = identify_rom(image.data(), (int)image.size(), NULL, 0);
+	CHECK(scanned.scheme == "F8");
+	CHECK(!scanned.known);
+	CHECK(scanned.md5 == md5);
+
+	std::vector<std::string> digests = { "00000000000000000000000000000000", md5, "ffffffffffffffffffffffffffffffff" };
+	std::sort(digests.begin(), digests.end());
+	std::vector<RomEntry> table;
+	for (const std::string& digest : digests) {
+		RomEntry e = { digest.c_str(), "F8", TvStandard::NTSC, Controller::JOYSTICK, Controller::JOYSTICK, "other" };
+		if (digest == md5) { e = { digest.c_str(), "3F", TvStandard::PAL, Controller::PADDLES, Controller::DRIVING, "row" }; }
+		table.push_back(e);
+	}
+	RomInfo found = identify_rom(image.data(), (int)image.size(), table.data(), (int)table.size());
+	CHECK(found.known);
+	CHECK(found.scheme == "3F");
+	CHECK(found.tv == TvStandard::PAL);
+	CHECK(found.left == Controller::PADDLES);
+	CHECK(found.right == Controller::DRIVING);
+	CHECK(found.name == "row");
+	CHECK(find_rom("0123", table.data(), (int)table.size()) == NULL);
+	CHECK(find_rom("~", table.data(), (int)table.size()) == NULL);
+
+	RomInfo embedded = identify_rom(image.data(), (int)image.size()); //not in the embedded table, same as the scan
+	CHECK(embedded.scheme == scanned.scheme);
+	CHECK(!embedded.known);
+}
+
+void test_romdb() {
+	digests();
+	embedded_table();
+	table_wins();
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <vector>
+
+#include "check.h"
+#include "../cartridge.h"
+#include "../cpu.h"
+#include "../snapshot.h"
+
+// Snapshot round trips for every mapper. Each machine runs a loop that keeps the banks, cartridge RAM, DPC fetchers,
+// RIOT timer, stack and TIA busy, the same code sits at $1F00 of every 4K so it survives its own bank switches.
+// A snapshot loaded into another machine must save back byte for byte, and both machines must then stay in step.
+
+static const unsigned char exerciser[] = { //$1F00
+	0xA2, 0xFF, 0x9A, //LDX #$FF, TXS
+	0xE6, 0x80, //loop: INC $80
+	0xA5, 0x80, 0x29, 0x1F, 0xAA, //LDA $80, AND #$1F, TAX
+	0xBD, 0xE0, 0x1F, //LDA $1FE0,X: F4/F6/F8, E0 and E7 hotspots
+	0x86, 0x3F, //STX $3F: 3F
+	0xBD, 0x00, 0x10, //LDA $1000,X: DPC fetchers
+	0x5D, 0x00, 0x14, 0x5D, 0x00, 0x18, //EOR $1400,X, EOR $1800,X: whatever the other slices hold ends up in RAM
+	0x9D, 0x40, 0x10, //STA $1040,X: DPC fetchers, Superchip and E7 RAM
+	0x85, 0x81, //STA $81
+	0x8D, 0x96, 0x02, //STA TIM64T
+	0x20, 0x40, 0xFF, //JSR $FF40: FE bank 0
+	0x20, 0x40, 0x1F, //JSR $1F40: FE bank 1
+	0x85, 0x09, //STA COLUBK
+	0x85, 0x02, //STA WSYNC
+	0x4C, 0x03, 0x1F, //JMP loop
+};
+static const unsigned char subroutine[] = { 0xAD, 0x84, 0x02, 0x65, 0x82, 0x85, 0x82, 0x60 }; //$1F40: LDA INTIM, ADC $82, STA $82, RTS
+
+static std::vector<unsigned char> exerciser_image(int size) {
+	std::vector<unsigned char> image(size);
+	for (int i = 0; i < size; i++) { image[i] = (unsigned char)(i * 7 + (i >> 8)); } //DPC display data, E7 ROM banks
+	for (int chunk = 0; chunk + 0x1000 <= size; chunk += 0x1000) {
+		std::copy(exerciser, exerciser + sizeof(exerciser), image.begin() + chunk + 0xF00);
+		std::copy(subroutine, subroutine + sizeof(subroutine), image.begin() + chunk + 0xF40);
+		image[chunk + 0xFFC] = 0x00;
+		image[chunk + 0xFFD] = 0x1F;
+	}
+	return image;
+}
+
+static std::vector<unsigned char> save(const Processor& cpu, const MemIO& mem) {
+	std::vector<unsigned char> snapshot(snapshot_size(mem));
+	CHECK_EQUAL(snapshot.size(), save_snapshot(cpu, mem, snapshot.data(), (int)snapshot.size()));
+	return snapshot;
+}
+
+static void round_trip(const char* scheme, int size) {
+	std::vector<unsigned char> image = exerciser_image(size);
+	MemIO mem_a(0x10000, "colors.csv", 228, 262);
+	MemIO mem_b(0x10000, "colors.csv", 228, 262);
+	mem_a.insert_cartridge(Cartridge::create(image.data(), size, scheme));
+	mem_b.insert_cartridge(Cartridge::create(image.data(), size, scheme));
+	Processor cpu_a(mem_a);
+	Processor cpu_b(mem_b);
+	cpu_a.run_cycles(mem_a, 40000);
+	for (int i = 0; i < 13; i++) { cpu_a.cpu_tick(mem_a); } //likely mid-instruction
+	cpu_b.run_cycles(mem_b, 12345); //somewhere else entirely
+
+	std::vector<unsigned char> saved = save(cpu_a, mem_a);
+	CHECK(load_snapshot(cpu_b, mem_b, saved.data(), (int)saved.size()));
+	CHECK(save(cpu_b, mem_b) == saved);
+
+	for (int i = 0; i < 500; i++) { //both go on the same way, cycle by cycle then in batches
+		cpu_a.cpu_tick(mem_a);
+		cpu_b.cpu_tick(mem_b);
+	}
+	cpu_a.run_cycles(mem_a, 30000);
+	cpu_b.run_cycles(mem_b, 30000);
+	std::vector<unsigned char> later = save(cpu_a, mem_a);
+	CHECK(save(cpu_b, mem_b) == later);
+	CHECK(later != saved);
+	CHECK(load_snapshot(cpu_a, mem_a, later.data(), (int)later.size())); //onto itself
+	CHECK(save(cpu_a, mem_a) == later);
+
+	std::vector<unsigned char> bad = saved; //rejected snapshots leave the machine alone
+	bad[0] = bad[0] ^ 1;
+	CHECK(!load_snapshot(cpu_a, mem_a, bad.data(), (int)bad.size()));
+	CHECK(!load_snapshot(cpu_a, mem_a, saved.data(), (int)saved.size() - 1));
+	CHECK(save(cpu_a, mem_a) == later);
+}
+
+static void other_cartridge(const char* saved_scheme, int saved_size, const char* loaded_scheme, int loaded_size) { //a snapshot only loads into a machine with the same cartridge
+	std::vector<unsigned char> image_a = exerciser_image(saved_size);
+	std::vector<unsigned char> image_b = exerciser_image(loaded_size);
+	MemIO mem_a(0x10000, "colors.csv", 228, 262);
+	MemIO mem_b(0x10000, "colors.csv", 228, 262);
+	mem_a.insert_cartridge(Cartridge::create(image_a.data(), saved_size, saved_scheme));
+	mem_b.insert_cartridge(Cartridge::create(image_b.data(), loaded_size, loaded_scheme));
+	Processor cpu_a(mem_a);
+	Processor cpu_b(mem_b);
+	mem_a.read(0x1FFB); //F4: bank 7, past the end of an 8K ROM
+	std::vector<unsigned char> saved = save(cpu_a, mem_a);
+	std::vector<unsigned char> before = save(cpu_b, mem_b);
+	CHECK(!load_snapshot(cpu_b, mem_b, saved.data(), (int)saved.size()));
+	CHECK(save(cpu_b, mem_b) == before);
+}
+
+static void bad_bank(const char* scheme, int size, int offset, unsigned char value) { //cartridge state naming a bank or slice the ROM does not have
+	std::vector<unsigned char> image = exerciser_image(size);
+	MemIO mem(0x10000, "colors.csv", 228, 262);
+	mem.insert_cartridge(Cartridge::create(image.data(), size, scheme));
+	Processor cpu(mem);
+	cpu.run_cycles(mem, 5000);
+	std::vector<unsigned char> before = save(cpu, mem);
+	std::vector<unsigned char> bad = before;
+	bad[sizeof(MachineState) + offset] = value;
+	CHECK(!load_snapshot(cpu, mem, bad.data(), (int)bad.size()));
+	CHECK(save(cpu, mem) == before);
+	CHECK(load_snapshot(cpu, mem, before.data(), (int)before.size()));
+}
+
+void test_snapshot() {
+	round_trip("4K", 0x1000);
+	round_trip("F8", 0x2000);
+	round_trip("F8SC", 0x2000);
+	round_trip("F6", 0x4000);
+	round_trip("F6SC", 0x4000);
+	round_trip("F4", 0x8000);
+	round_trip("F4SC", 0x8000);
+	round_trip("FE", 0x2000);
+	round_trip("E0", 0x2000);
+	round_trip("3F", 0x2000);
+	round_trip("E7", 0x4000);
+	round_trip("DPC", 0x2800);
+	other_cartridge("F8SC", 0x2000, "F8", 0x2000); //state sizes differ
+	other_cartridge("F4", 0x8000, "F8", 0x2000); //same state size, other ROM size
+	other_cartridge("3F", 0x2000, "F8", 0x2000); //same state and ROM size, other scheme
+	other_cartridge("F6", 0x4000, "E7", 0x4000);
+	bad_bank("F8", 0x2000, 0, 2);
+	bad_bank("F6SC", 0x4000, 0, 4);
+	bad_bank("FE", 0x2000, 0, 2);
+	bad_bank("FE", 0x2000, 1, 2);
+	bad_bank("E0", 0x2000, 2, 8);
+	bad_bank("3F", 0x2000, 0, 4);
+	bad_bank("E7", 0x4000, 0, 8);
+	bad_bank("E7", 0x4000, 1, 4);
+	bad_bank("DPC", 0x2800, 0, 2);
+	bad_bank("DPC", 0x2800, 1 + 16 + 1, 0x08); //high byte of the first fetcher counter, past 11 bits
+}
@@ -0,0 +1,90 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "check.h"
+#include "../threadpool.h"
+
+// parallel_for must run every item exactly once whatever the thread count, the grain and the item count, with owners
+// taking from the front and thieves splitting off the back of the same ranges. Items cost different amounts so threads
+// run dry at different times and the stealing gets exercised, not only the first even split.
+
+struct Job {
+	int count;
+	int grain; //0 when the pool runs everything itself in one call
+	std::atomic<int>* hits; //per item, how often it ran
+	std::atomic<int> bad_ranges; //empty, reversed, out of bounds or bigger than the grain
+	std::atomic<unsigned int> sink; //keeps the busy work from being optimized away
+};
+
+static void count_items(void* context, int begin, int end) {
+	Job& job = *(Job*)context;
+	if ((begin < 0) || (end > job.count) || (begin >= end)) { job.bad_ranges++; }
+	if ((job.grain > 0) && (end - begin > job.grain)) { job.bad_ranges++; }
+	for (int i = begin; i < end; i++) {
+		if ((i < 0) || (i >= job.count)) { continue; }
+		unsigned int work = 0;
+		for (int n = 0; n < (i % 7) * 200; n++) { work = work * 33 + n; } //uneven items
+		job.sink += work;
+		job.hits[i]++;
+	}
+}
+
+static void exactly_once(ThreadPool& pool, int count, int grain) {
+	Job job;
+	job.count = count;
+	job.grain = (pool.threads() == 1) ? 0 : ((grain > 0) ? grain : 1);
+	job.hits = new std::atomic<int>[count > 0 ? count : 1];
+	for (int i = 0; i < count; i++) { job.hits[i].store(0); }
+	job.bad_ranges.store(0);
+	job.sink.store(0);
+	pool.parallel_for(count, grain, &count_items, &job);
+	int missed = 0;
+	int repeated = 0;
+	for (int i = 0; i < count; i++) {
+		if (job.hits[i] == 0) { missed++; }
+		if (job.hits[i] > 1) { repeated++; }
+	}
+	CHECK_EQUAL(0, missed);
+	CHECK_EQUAL(0, repeated);
+	CHECK_EQUAL(0, job.bad_ranges.load());
+	delete[] job.hits;
+}
+
+static void slow_front(void* context, int begin, int end) { //the caller's share of four is slow, everyone else's is free
+	Job& job = *(Job*)context;
+	for (int i = begin; i < end; i++) {
+		if (i < job.count / 4) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+		job.hits[i]++;
+	}
+}
+
+void test_threadpool() {
+	static const int thread_counts[] = { 1, 2, 3, 4, 8, 17 };
+	static const int counts[] = { 0, 1, 2, 3, 5, 16, 17, 100, 1000 };
+	for (int threads : thread_counts) {
+		ThreadPool pool(threads); //one pool per size, reused for every job the way the batch steps reuse theirs
+		CHECK_EQUAL(threads, pool.threads());
+		for (int round = 0; round < 3; round++) {
+			for (int count : counts) {
+				for (int grain = 0; grain <= 6; grain++) { exactly_once(pool, count, grain); }
+			}
+		}
+		exactly_once(pool, 1000, 1000); //one grain holds everything
+		exactly_once(pool, 1000, -5); //negative grain means one
+	}
+
+	ThreadPool pool(4); //the others finish their shares at once and have to take from the caller's
+	Job job;
+	job.count = 64;
+	job.hits = new std::atomic<int>[job.count];
+	for (int i = 0; i < job.count; i++) { job.hits[i].store(0); }
+	pool.parallel_for(job.count, 1, &slow_front, &job);
+	int wrong = 0;
+	for (int i = 0; i < job.count; i++) {
+		if (job.hits[i] != 1) { wrong++; }
+	}
+	CHECK_EQUAL(0, wrong);
+	CHECK(pool.steals() > 0);
+	delete[] job.hits;
+}
@@ -0,0 +1,51 @@
+#include <iostream>
+
+#include "check.h"
+
+// Regression tests, one test_*.cpp per area. No framework: every test is a function of CHECKs listed below.
+// Run from the repository root, the machine loads colors.csv from there. Outside Visual Studio:
+//   g++ -std=c++14 -O2 -I. tests/*.cpp $(ls *.cpp | grep -v main.cpp) -lpthread -o run_tests && ./run_tests
+
+int checks_run = 0;
+int checks_failed = 0;
+
+void test_cpu();
+void test_riot();
+void test_idle();
+void test_mapper();
+void test_snapshot();
+void test_rewind();
+void test_jit();
+void test_decimal();
+void test_romdb();
+void test_threadpool();
+void test_batch();
+
+struct Test {
+	const char* name;
+	void (*run)();
+};
+
+static const Test tests[] = {
+	{ "cpu", &test_cpu },
+	{ "riot", &test_riot },
+	{ "idle", &test_idle },
+	{ "mapper", &test_mapper },
+	{ "snapshot", &test_snapshot },
+	{ "rewind", &test_rewind },
+	{ "jit", &test_jit },
+	{ "decimal", &test_decimal },
+	{ "romdb", &test_romdb },
+	{ "threadpool", &test_threadpool },
+	{ "batch", &test_batch },
+};
+
+int main() {
+	for (const Test& test : tests) {
+		int failed_before = checks_failed;
+		test.run();
+		std::cout << test.name << (checks_failed == failed_before ? ": ok" : ": FAILED") << std::endl;
+	}
+	std::cout << checks_run << " checks, " << checks_failed << " failed" << std::endl;
+	return (checks_failed == 0) ? 0 : 1;
+}
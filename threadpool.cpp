@@ -0,0 +1,148 @@
+#include <new>
+
+#include "threadpool.h"
+#include "framebuffer.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static unsigned long long pack_range(unsigned int begin, unsigned int end) {
+	return ((unsigned long long)begin << 32) | end;
+}
+
+static void pin_to_core(int core) { //best effort, a failure only costs locality
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores > 0) { core = core % cores; } //more threads than cores share them round robin
+#if defined(_WIN32)
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (core % (8 * sizeof(DWORD_PTR))));
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core % CPU_SETSIZE, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+ThreadPool::ThreadPool(int threads, bool pin) {
+	if (threads <= 0) { threads = std::thread::hardware_concurrency(); }
+	if (threads <= 0) { threads = 1; }
+	thread_count = threads;
+	slots = (Slot*)aligned_block(sizeof(Slot) * thread_count);
+	for (int i = 0; i < thread_count; i++) { new (&slots[i]) Slot(); slots[i].range.store(0); }
+	job = 0;
+	stopping = 0;
+	active = 0;
+	task = NULL;
+	context = NULL;
+	grain = 1;
+	steal_count.store(0);
+	workers = new std::thread[thread_count - 1];
+	for (int i = 1; i < thread_count; i++) { workers[i - 1] = std::thread(&ThreadPool::worker_loop, this, i, pin); }
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = 1;
+	}
+	wake.notify_all();
+	for (int i = 0; i < thread_count - 1; i++) { workers[i].join(); }
+	delete[] workers;
+	for (int i = 0; i < thread_count; i++) { slots[i].~Slot(); }
+	free_block((unsigned char*)slots);
+}
+
+void ThreadPool::parallel_for(int count, int grain, RangeTask task, void* context) {
+	if (count <= 0) { return; }
+	if (thread_count == 1) { //nothing to share
+		task(context, 0, count);
+		return;
+	}
+	this->task = task;
+	this->context = context;
+	this->grain = (grain > 0) ? grain : 1;
+	for (int i = 0; i < thread_count; i++) { //contiguous shares, the stealing evens out whatever they cost
+		unsigned int begin = (unsigned long long)count * i / thread_count;
+		unsigned int end = (unsigned long long)count * (i + 1) / thread_count;
+		slots[i].range.store(pack_range(begin, end));
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		active = thread_count;
+		job++;
+	}
+	wake.notify_all();
+	work(0);
+	std::unique_lock<std::mutex> guard(lock);
+	active--;
+	finished.wait(guard, [this] { return active == 0; });
+}
+
+void ThreadPool::worker_loop(int index, bool pin) {
+	if (pin) { pin_to_core(index); }
+	unsigned long long seen = 0;
+	while (1) {
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this, seen] { return stopping || (job != seen); });
+			if (stopping) { return; }
+			seen = job;
+		}
+		work(index);
+		bool last;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			active--;
+			last = (active == 0);
+		}
+		if (last) { finished.notify_one(); }
+	}
+}
+
+void ThreadPool::work(int index) {
+	int begin, end;
+	do {
+		while (take(index, begin, end)) { task(context, begin, end); }
+	} while (steal(index));
+}
+
+bool ThreadPool::take(int index, int& begin, int& end) { //front of the own range, grain items
+	std::atomic<unsigned long long>& range = slots[index].range;
+	unsigned long long current = range.load();
+	while (1) {
+		unsigned int b = current >> 32;
+		unsigned int e = (unsigned int)current;
+		if (b >= e) { return 0; }
+		unsigned int next = (e - b > (unsigned int)grain) ? b + grain : e;
+		if (range.compare_exchange_weak(current, pack_range(next, e))) {
+			begin = b;
+			end = next;
+			return 1;
+		}
+	}
+}
+
+bool ThreadPool::steal(int thief) { //back half of the first non-empty range after the thief's, moved into the thief's slot
+	for (int n = 1; n < thread_count; n++) {
+		std::atomic<unsigned long long>& range = slots[(thief + n) % thread_count].range;
+		unsigned long long current = range.load();
+		while (1) {
+			unsigned int b = current >> 32;
+			unsigned int e = (unsigned int)current;
+			if (b >= e) { break; }
+			unsigned int middle = b + (e - b) / 2; //a single item goes whole
+			if (range.compare_exchange_weak(current, pack_range(b, middle))) {
+				slots[thief].range.store(pack_range(middle, e)); //own slot was empty, thieves may now split it further
+				steal_count.fetch_add(1);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
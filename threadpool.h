@@ -0,0 +1,52 @@
+#pragma once
+#define THREADPOOL_H
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Fork-join pool for stepping many independent instances. parallel_for splits the items into one contiguous range
+// per thread; each thread eats its range from the front, grain items at a time, and once it runs dry steals the back
+// half of another thread's range. Ranges are single 64-bit words changed with compare-and-swap, so owner and thieves
+// never lock. Workers can be pinned one per core (opt-in, pools pinning side by side would fight over the same cores),
+// and every per-thread slot sits on its own cache line.
+
+typedef void (*RangeTask)(void* context, int begin, int end); //runs items [begin, end)
+
+class ThreadPool {
+public:
+	ThreadPool(int threads = 0, bool pin = 0); //threads counts the caller, 0: one per hardware thread. pin: one worker per core, only for a pool that has the machine to itself
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void parallel_for(int count, int grain, RangeTask task, void* context); //returns once every item ran, the caller works too
+	int threads() const { return thread_count; }
+	unsigned long long steals() const { return steal_count.load(); } //ranges taken from another thread since construction
+
+private:
+	struct alignas(64) Slot { //one per thread, a cache line each so owners and thieves only collide on purpose
+		std::atomic<unsigned long long> range; //begin in the high 32 bits, end in the low ones
+	};
+	Slot* slots;
+	int thread_count;
+	std::thread* workers; //thread_count - 1, slot 0 belongs to the caller
+
+	std::mutex lock;
+	std::condition_variable wake; //a new job was posted
+	std::condition_variable finished; //the last thread left the job
+	unsigned long long job; //bumped per parallel_for
+	bool stopping;
+	int active; //threads still in the current job
+
+	RangeTask task;
+	void* context;
+	int grain;
+	std::atomic<unsigned long long> steal_count;
+
+	void worker_loop(int index, bool pin);
+	void work(int index); //own range, then steal until nothing is left anywhere
+	bool take(int index, int& begin, int& end);
+	bool steal(int thief);
+};
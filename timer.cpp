@@ -17,6 +17,5 @@ void Clock::tick() {
 		//cpu processing routine TBD
 		cpu_clock = 0; //resetting delay
 	}
-	// TIA video processing routine
-}	//update video
-	//generate frame
\ No newline at end of file
+	// TIA video is not ticked here, MemIO renders it lazily in spans when registers change (see MemIO::render_to)
+}
\ No newline at end of file
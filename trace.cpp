@@ -0,0 +1,88 @@
+#include <iostream>
+#include <chrono>
+
+#include "trace.h"
+
+TraceBuffer::TraceBuffer(unsigned int capacity_log2) {
+	unsigned int capacity = 1u << capacity_log2;
+	ring = new TraceRecord[capacity]; //allocated once, the CPU side never allocates
+	mask = capacity - 1;
+	head = 0;
+	tail = 0;
+	drop_count = 0;
+	draining = 0;
+	drain_file = NULL;
+}
+
+TraceBuffer::~TraceBuffer() {
+	stop_drain();
+	delete[] ring;
+}
+
+bool TraceBuffer::push(const TraceRecord& record) {
+	unsigned int h = head.load(std::memory_order_relaxed);
+	unsigned int t = tail.load(std::memory_order_acquire);
+	if (h - t > mask) { //ring full, consumer is behind
+		drop_count.fetch_add(1, std::memory_order_relaxed);
+		return 0;
+	}
+	ring[h & mask] = record;
+	head.store(h + 1, std::memory_order_release); //publishes the record to the consumer
+	return 1;
+}
+
+unsigned int TraceBuffer::pop(TraceRecord* out, unsigned int max_records) {
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	unsigned int h = head.load(std::memory_order_acquire);
+	unsigned int count = h - t;
+	if (count > max_records) { count = max_records; }
+	for (unsigned int i = 0; i < count; i++) {
+		out[i] = ring[(t + i) & mask];
+	}
+	tail.store(t + count, std::memory_order_release); //hands the slots back to the producer
+	return count;
+}
+
+unsigned long long TraceBuffer::dump(std::FILE* file) {
+	TraceRecord batch[256];
+	unsigned long long total = 0;
+	unsigned int n;
+	while ((n = pop(batch, 256)) > 0) {
+		std::fwrite(batch, sizeof(TraceRecord), n, file);
+		total = total + n;
+	}
+	return total;
+}
+
+bool TraceBuffer::start_drain(std::string filename) {
+	if (draining) { return 0; } //already running
+	drain_file = std::fopen(filename.c_str(), "wb");
+	if (drain_file == NULL) {
+		std::cerr << "Error opening trace file" << std::endl;
+		return 0;
+	}
+	draining = 1;
+	drainer = std::thread(&TraceBuffer::drain_loop, this);
+	return 1;
+}
+
+void TraceBuffer::stop_drain() {
+	if (!draining) { return; }
+	draining = 0;
+	drainer.join();
+	dump(drain_file); //records pushed after the thread's last pass
+	std::fclose(drain_file);
+	drain_file = NULL;
+}
+
+unsigned long long TraceBuffer::dropped() {
+	return drop_count.load(std::memory_order_relaxed);
+}
+
+void TraceBuffer::drain_loop() {
+	while (draining) {
+		if (dump(drain_file) == 0) { //nothing pending, let the CPU fill the ring
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#define TRACE_H
+
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cstdio>
+
+// Instruction tracing. Compiled in only when CPU_TRACE is defined (Debug configurations), and even then off until a
+// TraceBuffer is handed to Processor::set_trace. Records are fixed-size and binary so the CPU never formats text.
+
+struct TraceRecord { //one executed instruction, state before execution
+	unsigned long long cycle; //system clock when the instruction started
+	unsigned short PC;
+	unsigned char opcode;
+	unsigned char A;
+	unsigned char X;
+	unsigned char Y;
+	unsigned char SP;
+	unsigned char SR; //status register packed with pack_SR
+};
+
+class TraceBuffer { //preallocated single-producer/single-consumer ring. The CPU pushes, a drain thread or dump() pops
+public:
+	TraceBuffer(unsigned int capacity_log2 = 16); //ring holds 2^capacity_log2 records
+	~TraceBuffer();
+	TraceBuffer(const TraceBuffer&) = delete;
+	TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+	bool push(const TraceRecord& record); //producer side, never blocks. Returns FALSE and counts a drop when the ring is full
+	unsigned int pop(TraceRecord* out, unsigned int max_records); //consumer side, returns how many records were copied out
+	unsigned long long dump(std::FILE* file); //consumer side, writes every pending record to file, returns count written
+
+	bool start_drain(std::string filename); //spawns a thread that keeps emptying the ring into filename
+	void stop_drain(); //flushes what is left and joins the drain thread
+
+	unsigned long long dropped(); //records lost because the ring was full
+
+private:
+	TraceRecord* ring;
+	unsigned int mask; //capacity - 1, capacity is a power of two
+	alignas(64) std::atomic<unsigned int> head; //next slot to write, owned by the producer
+	alignas(64) std::atomic<unsigned int> tail; //next slot to read, owned by the consumer
+	alignas(64) std::atomic<unsigned long long> drop_count;
+
+	std::thread drainer;
+	std::atomic<bool> draining;
+	std::FILE* drain_file;
+	void drain_loop();
+};